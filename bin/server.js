@@ -9,6 +9,9 @@ const rootDirectory = process.argv[2] ? path.resolve(process.argv[2]) : path.joi
 // Port on which the server will run
 const port = 3333;
 
+// Size of a ListItem_t record: name pointer (4) + size in KB (2) + load method (1)
+const LISTITEM_SIZE = 7;
+
 // Create and HTTP server
 const server = http.createServer((req, res) => {
 	// Obtain the requested path
@@ -24,6 +27,12 @@ const server = http.createServer((req, res) => {
 
 	console.log(`${getDate()} -> [${req.method}] [HTTP/${req.httpVersion}] [${req.socket.remoteAddress.replace(/^.*:/, '')}]: ${requestedPath}`);
 
+	// Local stand-in for the file-hunter list API
+	if (requestedPath.startsWith("/index4.php")) {
+		serveListApi(req, res);
+		return;
+	}
+
 	// Build the complete file path
 	const filePath = path.join(rootDirectory, requestedPath);
 	// Verify that the requested path is within the root directory to avoid security issues
@@ -91,6 +100,80 @@ server.listen(port, () => {
 	console.log(`#### Root directory: ${rootDirectory}`);
 });
 
+// Emulates index4.php: binary ListItem_t table + 4 zero bytes + NUL terminated names,
+// with the name pointers based at 'base' (hex). Supports 'offset'/'limit' paging,
+// telling the whole list size in the X-Total-Count header.
+function serveListApi(req, res) {
+	const params = new URL(req.url, 'http://localhost').searchParams;
+	const type = (params.get('type') || '').toLowerCase();
+	const search = (params.get('char') || '').toLowerCase();
+	const base = parseInt(params.get('base') || '2780', 16);
+	const download = params.get('download');
+
+	const files = fs.readdirSync(rootDirectory)
+		.filter(name => fs.statSync(path.join(rootDirectory, name)).isFile())
+		.filter(name => !type || path.extname(name).toLowerCase() === '.' + type)
+		.filter(name => name.toLowerCase().includes(search))
+		.sort();
+
+	// Download the n-th file of the list, preceded by a line with its name.
+	// A Range request is served over that whole response.
+	if (download) {
+		const name = files[parseInt(download, 10)];
+		if (name === undefined) {
+			res.statusCode = 404;
+			res.end('404 Not Found');
+			return;
+		}
+		const data = fs.readFileSync(path.join(rootDirectory, name));
+		let body = Buffer.concat([Buffer.from(name + '\n', 'latin1'), data]);
+
+		const range = req.headers.range && req.headers.range.match(/bytes=(\d+)-(\d*)/);
+		if (range) {
+			const start = parseInt(range[1], 10);
+			const end = range[2] ? parseInt(range[2], 10) : body.length - 1;
+			if (start >= body.length || end >= body.length || start > end) {
+				res.statusCode = 416; // Range Not Satisfiable
+				res.setHeader('Content-Range', `bytes */${body.length}`);
+				res.end();
+				console.log(`${getDate()} << #### 416 Range Not Satisfiable: ${req.headers.range}`);
+				return;
+			}
+			res.statusCode = 206; // Partial Content
+			res.setHeader('Content-Range', `bytes ${start}-${end}/${body.length}`);
+			body = body.subarray(start, end + 1);
+		}
+		res.setHeader('Content-Type', 'application/octet-stream');
+		res.setHeader('Content-Length', body.length);
+		res.end(body);
+		console.log(`${getDate()} << Download: ${name} [${body.length} bytes]`);
+		return;
+	}
+
+	const offset = params.has('offset') ? parseInt(params.get('offset'), 10) : 0;
+	const limit = params.has('limit') ? parseInt(params.get('limit'), 10) : files.length;
+	const page = files.slice(offset, offset + limit);
+
+	const table = Buffer.alloc(page.length * LISTITEM_SIZE + 4);
+	const names = [];
+	let nameAddress = base;
+	page.forEach((name, i) => {
+		const size = Math.ceil(fs.statSync(path.join(rootDirectory, name)).size / 1024);
+		table.writeUInt32LE(nameAddress, i * LISTITEM_SIZE);
+		table.writeUInt16LE(Math.min(size, 0xffff), i * LISTITEM_SIZE + 4);
+		table.writeUInt8(0, i * LISTITEM_SIZE + 6);
+		names.push(Buffer.from(name + '\0', 'latin1'));
+		nameAddress += name.length + 1;
+	});
+
+	const body = Buffer.concat([table, ...names]);
+	res.setHeader('Content-Type', 'application/octet-stream');
+	res.setHeader('Content-Length', body.length);
+	res.setHeader('X-Total-Count', files.length);
+	res.end(body);
+	console.log(`${getDate()} << List: ${page.length}/${files.length} items from ${offset} [${body.length} bytes]`);
+}
+
 function getDate() {
 	let date = new Date();
 	return date.toISOString().slice(0,10)+" "+date.toTimeString().slice(0,8)+"."+date.getMilliseconds().toString().padStart(3, '0');
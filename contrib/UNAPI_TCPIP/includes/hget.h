@@ -59,6 +59,7 @@
 
 #define TCP_BUFFER_SIZE (1024)
 #define TCPOUT_STEP_SIZE (512)
+#define RECEIVE_BUFFER_MAX (0x4000)
 
 #define HTTP_DEFAULT_PORT (80)
 #define HTTPS_DEFAULT_PORT (443)
@@ -69,6 +70,24 @@
 
 #define MAX_REDIRECTIONS 10
 
+#define CHUNK_SIZE 0            // Hex digits of the chunk size
+#define CHUNK_SIZE_LINE 1       // Extensions up to the LF
+#define CHUNK_DATA 2
+#define CHUNK_DATA_END 3        // CRLF after the data
+#define CHUNK_TRAILER 4         // Start of a trailer line
+#define CHUNK_TRAILER_LINE 5    // Trailer contents up to the LF
+#define CHUNK_TRAILER_END 6     // LF of the empty line closing the body
+#define CHUNK_DONE 7
+
+#define HGET_STATE_IDLE 0
+#define HGET_STATE_CONNECT 1    // Address from the DNS cache or a new query
+#define HGET_STATE_RESOLVE 2    // DNS query in progress
+#define HGET_STATE_OPEN 3       // TCP connection being opened
+#define HGET_STATE_SEND 4       // Request being sent
+#define HGET_STATE_STATUS 5     // Status line of the response
+#define HGET_STATE_HEADERS 6    // Header lines up to the empty one
+#define HGET_STATE_CONTENTS 7
+
 typedef void (*funcptr)(bool);
 typedef void (*funcdataptr)(char *, int);
 typedef void (*funcsizeptr)(long);
@@ -79,6 +98,7 @@ typedef void (*funcsizeptr)(long);
 /* Global Variables */
 static const char *default_user_agent = "HGETLIB/1.3 (MSX)";
 static const char *user_agent;
+static char extraHeaders[HGET_HEADERS_SIZE];
 static bool continue_using_keep_alive;
 static byte conn;
 static char* domainName;
@@ -87,11 +107,24 @@ static bool redirectionRequested;
 static int remainingInputData;
 static byte* inputDataPointer;
 static byte emptyLineReaded;
+static byte hgetState = HGET_STATE_IDLE;
+static byte* sendPointer;
+static int sendRemaining;
+static byte* headerLinePointer;
+static bool headerLineEnded;
 static long contentLength,blockSize,currentBlock;
 static bool isChunkedTransfer;
 static long currentChunkSize;
+static byte chunkState;
+static byte chunkDigits;
+static byte* receiveBuffer;
+static unsigned int receiveBufferSize;
 static bool newLocationReceived;
 static long receivedLength;
+static long contentRangeStart;
+static char* watchedTitle;
+static char* watchedValue;
+static byte watchedSize;
 static byte* TcpInputData;
 #define TcpOutputData TcpInputData
 static byte remoteFilePath[256];
@@ -139,13 +172,16 @@ static bool thereisasavecallback = false;
 static bool thereisasizecallback = false;
 static bool hasinitialized = false;
 static bool indicateblockprogress = false;
+static HgetDnsEntry_t *dnsCache = NULL;
+static uint8_t dnsCacheEntries = 0;
+static uint8_t dnsCacheNext = 0;
+static HgetDnsEntry_t *dnsEntryUsed;
 
 /* Some handy defines */
 
 #define LetTcpipBreathe() UnapiCall(codeBlock, TCPIP_WAIT, &reg, REGS_NONE, REGS_NONE)
 #define SkipCharsWhile(pointer, ch) {while(*pointer == ch) pointer++;}
 #define SkipCharsUntil(pointer, ch) {while(*pointer != ch) pointer++;}
-#define SkipLF() GetInputByte(NULL)
 #define ToLowerCase(ch) {ch |= 32;}
 #define ResetTcpBuffer() {remainingInputData = 0; inputDataPointer = TcpInputData;}
 #define AbortIfEscIsPressed() ((*((byte*)0xFBEC) & 4) == 0 || cancelled_by_handler)
@@ -155,14 +191,16 @@ static bool indicateblockprogress = false;
 static void TerminateConnection();
 static HgetReturnCode_t ProcessUrl(char* url, bool isRedirection);
 inline void ExtractPortNumberFromDomainName();
-inline HgetReturnCode_t DoHttpWork();
+static HgetReturnCode_t StartHttpWork();
+static HgetReturnCode_t StartHttpRequest();
 inline HgetReturnCode_t SendHttpRequest();
 static HgetReturnCode_t ReadResponseHeaders();
-static HgetReturnCode_t SendLineToTcp(char* string);
 inline HgetReturnCode_t CheckHeaderErrors();
-inline HgetReturnCode_t DownloadHttpContents();
+inline void StartHttpContents();
+inline HgetReturnCode_t ReceiveHttpContents();
+static bool IsHttpContentsComplete();
 static HgetReturnCode_t SendCredentialsIfNecessary();
-inline HgetReturnCode_t ReadResponseStatus();
+inline void ReadResponseStatus();
 inline HgetReturnCode_t ProcessResponseStatus();
 static HgetReturnCode_t ReadNextHeader();
 inline HgetReturnCode_t ProcessNextHeader();
@@ -170,24 +208,28 @@ inline void ExtractHeaderTitleAndContents();
 static bool HeaderTitleIs(char* string);
 static bool HeaderContentsIs(char* string);
 inline HgetReturnCode_t DiscardBogusHttpContent();
-inline HgetReturnCode_t DoDirectDatatransfer();
-inline HgetReturnCode_t DoChunkedDataTransfer();
-static long GetNextChunkSize();
+inline HgetReturnCode_t ProcessDirectData();
+inline HgetReturnCode_t ProcessChunkedData();
 /* Functions Related to Callbacks Handling  */
 static void UpdateReceivingMessage();
 static bool WriteContents(byte* dataPointer, int size);
 /* Functions Related to Network I/O  */
 inline bool InitializeTcpipUnapi();
 inline bool CheckTcpipCapabilities();
-static HgetReturnCode_t EnsureThereIsTcpDataAvailable();
+static HgetReturnCode_t PollTcpData();
 inline bool EnsureTcpConnectionIsStillOpen();
 inline HgetReturnCode_t ReadAsMuchTcpDataAsPossible();
-static HgetReturnCode_t GetInputByte(byte *data);
+inline unsigned int ReceiveBufferRoom();
 inline bool CheckNetworkConnection();
 static HgetReturnCode_t OpenTcpConnection();
+static HgetReturnCode_t PollTcpConnection();
 static HgetReturnCode_t ResolveServerName();
+static HgetReturnCode_t QueryServerName();
+static HgetReturnCode_t PollServerName();
+static HgetDnsEntry_t* FindDnsEntry();
+static void StoreDnsEntry();
 static void CloseTcpConnection();
-inline HgetReturnCode_t SendTcpData(byte* data, int dataSize);
+inline HgetReturnCode_t SendTcpData();
 /* Functions Related to Strings  */
 static bool StringStartsWith(const char* stringToCheck, const char* startingToken);
 static uint8_t strcmpi(const char *a1, const char *a2);
@@ -116,6 +116,22 @@ void hgetSetUserAgent(const char* userAgent)
         user_agent = default_user_agent;
 }
 
+//Extra headers sent with the following requests, until they are cleared
+void hgetClearHeaders()
+{
+    *extraHeaders = '\0';
+}
+
+bool hgetAddHeader(const char* name, const char* value)
+{
+    int len = strlen(extraHeaders);
+
+    if (len + strlen(name) + strlen(value) + 4 >= HGET_HEADERS_SIZE)
+        return false;
+    sprintf(extraHeaders + len, "%s: %s\r\n", name, value);
+    return true;
+}
+
 
 void hgetfinish(void)
 {
@@ -133,6 +149,34 @@ HgetReturnCode_t hget(char* url, int progress_callback, bool checkcertificateifs
 #else
 HgetReturnCode_t hget(char* url, int progress_callback, int data_write_callback, int content_size_callback, bool enableKeepAlive)
 #endif
+{
+    HgetReturnCode_t funcret;
+
+#ifdef USE_TLS
+    funcret = hgetBegin(url, progress_callback, checkcertificateifssl, checkhostnameifssl, data_write_callback, content_size_callback, enableKeepAlive);
+#else
+    funcret = hgetBegin(url, progress_callback, data_write_callback, content_size_callback, enableKeepAlive);
+#endif
+    if (funcret != ERR_TCPIPUNAPI_OK)
+        return funcret;
+
+    do {
+        funcret = hgetStep();
+    } while (funcret == ERR_HGET_IN_PROGRESS);
+
+    hgetEnd();
+
+    return funcret;
+}
+
+//Prepares the request without waiting for the network: it is done calling
+//hgetStep until it stops returning ERR_HGET_IN_PROGRESS, and then hgetEnd.
+//hgetEnd is not needed if it fails.
+#ifdef USE_TLS
+HgetReturnCode_t hgetBegin(char* url, int progress_callback, bool checkcertificateifssl, bool checkhostnameifssl, int data_write_callback, int content_size_callback, bool enableKeepAlive)
+#else
+HgetReturnCode_t hgetBegin(char* url, int progress_callback, int data_write_callback, int content_size_callback, bool enableKeepAlive)
+#endif
 {
     HgetReturnCode_t funcret;
     char* pointer;
@@ -142,6 +186,9 @@ HgetReturnCode_t hget(char* url, int progress_callback, int data_write_callback,
 #endif
     cancelled_by_handler = false;
     receivedLength = 0;
+    receiveBuffer = NULL;
+    responseStatusCode = 0;
+    hgetState = HGET_STATE_IDLE;
 
     if (!hasinitialized)
         return ERR_HGET_NOT_INITIALIZED;
@@ -188,21 +235,127 @@ HgetReturnCode_t hget(char* url, int progress_callback, int data_write_callback,
         return ERR_TCPIPUNAPI_NO_CONNECTION;
     }
 
-    funcret = DoHttpWork();
+    redirectionRequests = 0;
+    funcret = StartHttpWork();
 
-    if (funcret != ERR_TCPIPUNAPI_OK)
+    if (funcret != ERR_TCPIPUNAPI_OK) {
         tryKeepAlive = false;
+        TerminateConnection();
+    }
 
-    TerminateConnection();
+    return funcret;
+}
 
+//Does one step of the request without waiting for the network: checking the
+//DNS query, the connection being opened, sending the request, reading the
+//received header lines or processing the received block of contents
+HgetReturnCode_t hgetStep()
+{
+    HgetReturnCode_t funcret;
+
+    switch (hgetState) {
+        case HGET_STATE_CONTENTS:
+            return ReceiveHttpContents();
+        case HGET_STATE_CONNECT:
+            funcret = ResolveServerName();
+            break;
+        case HGET_STATE_RESOLVE:
+            funcret = PollServerName();
+            break;
+        case HGET_STATE_OPEN:
+            funcret = PollTcpConnection();
+            break;
+        case HGET_STATE_SEND:
+            funcret = SendHttpRequest();
+            break;
+        case HGET_STATE_STATUS:
+        case HGET_STATE_HEADERS:
+            funcret = ReadResponseHeaders();
+            break;
+        default:    //No request in progress
+            return ERR_HGET_NOT_INITIALIZED;
+    }
+
+    if ((funcret == ERR_TCPIPUNAPI_OK) || (funcret == ERR_HGET_IN_PROGRESS))
+        return ERR_HGET_IN_PROGRESS;
+
+    if ((hgetState == HGET_STATE_OPEN) && (dnsEntryUsed) && ((funcret == ERR_TCPIPUNAPI_CONNECTION_FAILED) || (funcret == ERR_TCPIPUNAPI_CONNECTION_TIMEOUT))) {
+        //the cached address could be outdated, resolve it again once
+        CloseTcpConnection();
+        dnsEntryUsed->host[0] = '\0';
+        dnsEntryUsed = NULL;
+        funcret = QueryServerName();
+    } else if ((hgetState >= HGET_STATE_SEND) && (keepingConnectionAlive) && (continue_using_keep_alive)) {
+        //retry once with a new connection
+        keepingConnectionAlive = false;
+        funcret = StartHttpWork();
+    }
+    if ((funcret == ERR_TCPIPUNAPI_OK) || (funcret == ERR_HGET_IN_PROGRESS))
+        return ERR_HGET_IN_PROGRESS;
+
+    hgetState = HGET_STATE_IDLE;
+    tryKeepAlive = false;
+    TerminateConnection();
     return funcret;
 }
 
+//Keeps the connection alive only if the contents were fully received
+void hgetEnd()
+{
+    if ((hgetState != HGET_STATE_CONTENTS) || (!IsHttpContentsComplete()))
+        tryKeepAlive = false;
+    hgetState = HGET_STATE_IDLE;
+    receiveBuffer = NULL;
+    TerminateConnection();
+}
+
+//The next receive of contents goes straight to buffer instead of TcpInputData,
+//so the data write callback gets a pointer into it. It is used only once and
+//must be set again from the callback; like the hgetinit buffer, it can't be in
+//page 1. The chunked transfers use it only for the chunk data.
+void hgetSetReceiveBuffer(byte* buffer, unsigned int size)
+{
+    if (buffer && size && ((unsigned int)buffer>=0x8000 || ((unsigned int)buffer+size)<0x4000)) {
+        receiveBuffer = buffer;
+        receiveBufferSize = size > RECEIVE_BUFFER_MAX ? RECEIVE_BUFFER_MAX : size;
+    } else
+        receiveBuffer = NULL;
+}
+
 void hgetcancel()
 {
     cancelled_by_handler = true;
 }
 
+//The contents of the header title received in the next responses are copied
+//to value (empty if it is not received)
+void hgetWatchHeader(char* title, char* value, unsigned char size)
+{
+    watchedTitle = title;
+    watchedValue = value;
+    watchedSize = size;
+    if (value)
+        *value = '\0';
+}
+
+//Status code of the last response, also after a failed request
+int hgetGetStatusCode()
+{
+    return responseStatusCode;
+}
+
+//First byte of the contents for a 206 Partial Content response, -1 otherwise
+long hgetGetRangeStart()
+{
+    return responseStatusCode == 206 ? contentRangeStart : -1;
+}
+
+void hgetSetDnsCache(HgetDnsEntry_t *cache, uint8_t entries)
+{
+    dnsCache = cache;
+    dnsCacheEntries = entries;
+    dnsCacheNext = 0;
+}
 
 /****************************
  ***  FUNCTIONS are here  ***
@@ -319,185 +472,150 @@ inline void ExtractPortNumberFromDomainName()
 }
 
 
-inline HgetReturnCode_t DoHttpWork()
+//Starts over from the connection, reusing the kept alive one if possible
+HgetReturnCode_t StartHttpWork()
 {
-    HgetReturnCode_t funcret;
-    bool must_continue;
+    keepingConnectionAlive &= continue_using_keep_alive;
 
-    do {
-        must_continue = false;
-        redirectionRequests = 0;
-        keepingConnectionAlive &= continue_using_keep_alive;
+    //a kept alive connection could have been closed by the peer while idle
+    if ((keepingConnectionAlive)&&(!EnsureTcpConnectionIsStillOpen()))
+        keepingConnectionAlive = false;
 
-        ResetTcpBuffer();
+    ResetTcpBuffer();
 
-        if ((!keepingConnectionAlive)||((keepingConnectionAlive)&&(redirectionUrlIsNewDomainName))) {
-            funcret = ResolveServerName();
-            if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
+    if ((!keepingConnectionAlive)||(redirectionUrlIsNewDomainName)) {
+        CloseTcpConnection();
+        hgetState = HGET_STATE_CONNECT;
+        return ERR_TCPIPUNAPI_OK;
+    }
 
-            funcret = OpenTcpConnection();
-            if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
-        }
+    return StartHttpRequest();
+}
 
-        do {
-            // Initialize HTTP Variables
-            contentLength = 0;
-            redirectionRequested = false;
-            continueReceived = false;
-            isChunkedTransfer = false;
-            newLocationReceived = false;
-            indicateblockprogress = false;
 
-            funcret = SendHttpRequest();
-            if (funcret != ERR_TCPIPUNAPI_OK) {
-                if ((keepingConnectionAlive)&&(continue_using_keep_alive)) {
-                    keepingConnectionAlive = false;
-                    continue_using_keep_alive = false;
-                    must_continue = true;
-                    break;
-                }
-                else
-                    return funcret;
-            }
+//Prepares the request to be sent by the next steps
+HgetReturnCode_t StartHttpRequest()
+{
+    char* pointer = (char*)TcpOutputData;
+
+    // Initialize HTTP Variables
+    contentLength = 0;
+    redirectionRequested = false;
+    continueReceived = false;
+    isChunkedTransfer = false;
+    newLocationReceived = false;
+    indicateblockprogress = false;
+    contentRangeStart = -1;
+    if (watchedValue)
+        *watchedValue = '\0';
+
+    //The whole request goes in a single send
+    if (strlen(remoteFilePath) + strlen(domainName) + strlen(user_agent) + strlen(extraHeaders) + 64 > TCP_BUFFER_SIZE)
+        return ERR_HGET_INVALID_PARAMETERS;
 
-            funcret = ReadResponseHeaders();
-            if (funcret != ERR_TCPIPUNAPI_OK) {
-                if ((keepingConnectionAlive)&&(continue_using_keep_alive)) {
-                    keepingConnectionAlive = false;
-                    continue_using_keep_alive = false;
-                    must_continue = true;
-                    break;
-                }
-                else
-                    return funcret;
-            }
-
-            funcret = CheckHeaderErrors();
-            if (funcret != ERR_TCPIPUNAPI_OK) {
-                if ((keepingConnectionAlive)&&(continue_using_keep_alive)) {
-                    keepingConnectionAlive = false;
-                    continue_using_keep_alive = false;
-                    must_continue = true;
-                    break;
-                }
-                else
-                    return funcret;
-            }
-
-            if(redirectionRequested) {
-                if(redirectionUrlIsNewDomainName) {
-                    CloseTcpConnection();
-                    funcret = ResolveServerName();
-                    if (funcret != ERR_TCPIPUNAPI_OK)
-                        return funcret;
-                    funcret = OpenTcpConnection();
-                    if (funcret != ERR_TCPIPUNAPI_OK)
-                        return funcret;
-                }
-                ResetTcpBuffer();
-            } else if(continueReceived) {
-                funcret = DiscardBogusHttpContent();
-                if (funcret != ERR_TCPIPUNAPI_OK) {
-                    if ((keepingConnectionAlive)&&(continue_using_keep_alive)) {
-                        keepingConnectionAlive = false;
-                        continue_using_keep_alive = false;
-                        must_continue = true;
-                        break;
-                    }
-                    else
-                        return funcret;
-                }
-            }
-        } while(continueReceived || redirectionRequested);
+    pointer += sprintf(pointer, "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: %s\r\n", remoteFilePath, domainName, user_agent);
+    if (tryKeepAlive)
+        pointer += sprintf(pointer, "Connection: Keep-Alive\r\n");
+    pointer += sprintf(pointer, "%s\r\n", extraHeaders);
 
-        if (must_continue)
-            continue;
-        funcret = DownloadHttpContents();
-        break;
-    } while (1);
+    sendPointer = TcpOutputData;
+    sendRemaining = pointer - (char*)TcpOutputData;
+    hgetState = HGET_STATE_SEND;
 
-    return funcret;
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
 inline HgetReturnCode_t DiscardBogusHttpContent()
 {
-    HgetReturnCode_t funcret = ERR_TCPIPUNAPI_OK;
-    while(remainingInputData > 0) {
-        funcret = GetInputByte(NULL);
-        if (funcret!=ERR_TCPIPUNAPI_OK)
-            return funcret;
-    }
-    return funcret;
+    remainingInputData = 0;
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
+//Sends the next piece of the request, then waits for the response
 inline HgetReturnCode_t SendHttpRequest()
 {
     HgetReturnCode_t funcret;
-    sprintf(TcpOutputData, "GET %s HTTP/1.1\r\n", remoteFilePath);
-    funcret = SendLineToTcp(TcpOutputData);
-    if (funcret!=ERR_TCPIPUNAPI_OK)
-        return funcret;
-    sprintf(TcpOutputData, "Host: %s\r\n", domainName);
-    funcret = SendLineToTcp(TcpOutputData);
-    if (funcret!=ERR_TCPIPUNAPI_OK)
-        return funcret;
-    sprintf(TcpOutputData, "User-Agent: %s\r\n", user_agent);
-    funcret = SendLineToTcp(TcpOutputData);
-    if (funcret!=ERR_TCPIPUNAPI_OK)
+
+    funcret = SendTcpData();
+    if (funcret != ERR_TCPIPUNAPI_OK)
         return funcret;
-    if (tryKeepAlive) {
-        sprintf(TcpOutputData, "Connection: Keep-Alive\r\n");
-        funcret = SendLineToTcp(TcpOutputData);
-        if (funcret!=ERR_TCPIPUNAPI_OK)
-            return funcret;
-    }
-    sprintf(TcpOutputData,"\r\n");
-    funcret = SendLineToTcp(TcpOutputData);
-    return funcret;
+
+    emptyLineReaded = 0;
+    zeroContentLengthAnnounced = false;
+    headerLinePointer = headerLine;
+    headerLineEnded = false;
+    ticksWaited = 0;
+    sysTimerHold = *SYSTIMER;
+    hgetState = HGET_STATE_STATUS;
+
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
+//Processes the complete header lines received, polling once for more, and
+//once the empty line arrives goes on with the redirection, the request after
+//a 100 Continue or the contents
 HgetReturnCode_t ReadResponseHeaders()
 {
     HgetReturnCode_t funcret;
 
-    emptyLineReaded = 0;
-    zeroContentLengthAnnounced = false;
+    funcret = PollTcpData();
+    if (funcret != ERR_TCPIPUNAPI_OK)
+        return funcret;
 
-    funcret = ReadResponseStatus();
+    while ((funcret = ReadNextHeader()) == ERR_TCPIPUNAPI_OK) {
+        if (hgetState == HGET_STATE_STATUS) {
+            ReadResponseStatus();
+            hgetState = HGET_STATE_HEADERS;
+        } else if (!emptyLineReaded) {
+            funcret = ProcessNextHeader();
+            if (funcret != ERR_TCPIPUNAPI_OK)
+                return funcret;
+        } else
+            break;
+    }
+    if (funcret != ERR_TCPIPUNAPI_OK) {
+        if (funcret == ERR_HGET_IN_PROGRESS)
+            LetTcpipBreathe();
+        return funcret;
+    }
+
+    funcret = ProcessResponseStatus();
     if (funcret == ERR_TCPIPUNAPI_OK)
-    {
-        while(!emptyLineReaded) {
-            funcret = ReadNextHeader();
-            if (funcret == ERR_TCPIPUNAPI_OK)
-                funcret = ProcessNextHeader();
+        funcret = CheckHeaderErrors();
+    if (funcret != ERR_TCPIPUNAPI_OK)
+        return funcret;
+
+    if (redirectionRequested) {
+        ResetTcpBuffer();
+        if (redirectionUrlIsNewDomainName) {
+            CloseTcpConnection();
+            hgetState = HGET_STATE_CONNECT;
+            return ERR_TCPIPUNAPI_OK;
         }
-        if (funcret == ERR_TCPIPUNAPI_OK)
-            funcret = ProcessResponseStatus();
+        return StartHttpRequest();
+    }
+    if (continueReceived) {
+        DiscardBogusHttpContent();
+        return StartHttpRequest();
     }
 
-    return funcret;
+    StartHttpContents();
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
-inline HgetReturnCode_t ReadResponseStatus()
+inline void ReadResponseStatus()
 {
-    HgetReturnCode_t funcret;
     char* pointer;
-    funcret = ReadNextHeader();
-    if (funcret != ERR_TCPIPUNAPI_OK)
-        return funcret;
     strcpy(statusLine, headerLine);
     pointer = statusLine;
     SkipCharsUntil(pointer, ' ');
     SkipCharsWhile(pointer, ' ');
     responseStatusCode = atoi(pointer);
     responseStatusCodeFirstDigit = (byte)*pointer - (byte)'0';
-    return ERR_TCPIPUNAPI_OK;
 }
 
 
@@ -522,40 +640,45 @@ inline HgetReturnCode_t ProcessResponseStatus()
 }
 
 
+//Copies the line straight from the received block up to its CR; when the
+//block is drained first, what was copied is kept for the next step and it
+//returns ERR_HGET_IN_PROGRESS
 HgetReturnCode_t ReadNextHeader()
 {
-    char* pointer;
-    byte data;
-    HgetReturnCode_t funcret;
-    pointer = headerLine;
-
-    funcret = GetInputByte(&data);
-    if (funcret != ERR_TCPIPUNAPI_OK)
-        return funcret;
-    if(data == '\r') {
-        funcret = SkipLF();
-        if (funcret != ERR_TCPIPUNAPI_OK)
-            return funcret;
-        emptyLineReaded = 1;
-        return ERR_TCPIPUNAPI_OK;
+    byte* scan;
+    int size, room;
+
+    if (!headerLineEnded) {
+        scan = inputDataPointer;
+        size = remainingInputData;
+        while(size && *scan != '\r') {
+            scan++;
+            size--;
+        }
+        size = scan - inputDataPointer;
+        room = (int)(headerLine + sizeof(headerLine) - 1 - headerLinePointer);
+        if (room > size)
+            room = size;
+        memcpy(headerLinePointer, inputDataPointer, room);
+        headerLinePointer += room;
+        inputDataPointer = scan;
+        remainingInputData -= size;
+        if (remainingInputData == 0)
+            return ERR_HGET_IN_PROGRESS;
+        inputDataPointer++;     // Skip the CR
+        remainingInputData--;
+        headerLineEnded = true;
     }
-    *pointer = data;
-    pointer++;
 
-    do {
-        funcret = GetInputByte(&data);
-        if (funcret != ERR_TCPIPUNAPI_OK)
-            return funcret;
-        if(data == '\r') {
-            *pointer = '\0';
-            funcret = SkipLF();
-            if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
-        } else {
-            *pointer = data;
-            pointer++;
-        }
-    } while(data != '\r');
+    if (remainingInputData == 0)
+        return ERR_HGET_IN_PROGRESS;
+    inputDataPointer++;     // Skip the LF
+    remainingInputData--;
+
+    *headerLinePointer = '\0';
+    emptyLineReaded = (headerLinePointer == headerLine);
+    headerLinePointer = headerLine;
+    headerLineEnded = false;
 
     return ERR_TCPIPUNAPI_OK;
 }
@@ -583,6 +706,15 @@ inline HgetReturnCode_t ProcessNextHeader()
             zeroContentLengthAnnounced = true;
     }
 
+    if(watchedTitle && HeaderTitleIs(watchedTitle)) {
+        strncpy(watchedValue, headerContents, watchedSize - 1);
+        watchedValue[watchedSize - 1] = '\0';
+    }
+
+    if(HeaderTitleIs("Content-Range") && !strncmpi(headerContents, "bytes ", 6)) {
+        contentRangeStart = atol(headerContents + 6);
+    }
+
     if(HeaderTitleIs("Transfer-Encoding")) {
         if(HeaderContentsIs("Chunked")) {
             isChunkedTransfer = true;
@@ -646,127 +778,147 @@ bool HeaderContentsIs(char* string)
 }
 
 
-HgetReturnCode_t SendLineToTcp(char* string)
+inline void StartHttpContents()
 {
-    int len;
+    currentChunkSize = 0;
+    chunkState = CHUNK_SIZE;
+    chunkDigits = 0;
+    ticksWaited = 0;
+    sysTimerHold = *SYSTIMER;
+    hgetState = HGET_STATE_CONTENTS;
 
-    len = strlen(string);
-    return SendTcpData(string, len);
+	if (contentLength) {
+		blockSize = contentLength/25;
+		currentBlock = 0;
+		if (blockSize && !isChunkedTransfer)
+            indicateblockprogress = true;
+	}
 }
 
 
-inline HgetReturnCode_t DownloadHttpContents()
+//Processes the received block of contents, if any, without waiting for it
+inline HgetReturnCode_t ReceiveHttpContents()
 {
     HgetReturnCode_t funcret;
 
-    if(isChunkedTransfer) {
-        funcret = DoChunkedDataTransfer();
-    } else
-        funcret = DoDirectDatatransfer();
-
-    return funcret;
-}
-
-inline HgetReturnCode_t DoDirectDatatransfer()
-{
-    HgetReturnCode_t funcret = ERR_TCPIPUNAPI_OK;
+    if (IsHttpContentsComplete())
+        return ERR_TCPIPUNAPI_OK;
 
-    if(zeroContentLengthAnnounced) {
+    funcret = PollTcpData();
+    if (funcret != ERR_TCPIPUNAPI_OK)
         return funcret;
+    if (remainingInputData == 0) {
+        LetTcpipBreathe();
+        return ERR_HGET_IN_PROGRESS;
     }
 
-	if (contentLength) {
-		blockSize = contentLength/25;
-		currentBlock = 0;
-		if (blockSize)
-            indicateblockprogress = true;
-	}
+    if (isChunkedTransfer)
+        funcret = ProcessChunkedData();
+    else
+        funcret = ProcessDirectData();
+    if (funcret != ERR_TCPIPUNAPI_OK)
+        return funcret;
 
-    while(contentLength == 0 || receivedLength < contentLength) {
-        funcret = EnsureThereIsTcpDataAvailable();
-        if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
-        receivedLength += remainingInputData;
-        currentBlock += remainingInputData;
-        UpdateReceivingMessage();
-        if (!WriteContents(inputDataPointer, remainingInputData))
-            return ERR_HGET_DISK_WRITE_ERROR;
-        ResetTcpBuffer();
-    }
-    return funcret;
+    return IsHttpContentsComplete() ? ERR_TCPIPUNAPI_OK : ERR_HGET_IN_PROGRESS;
 }
 
 
-inline HgetReturnCode_t DoChunkedDataTransfer()
+bool IsHttpContentsComplete()
 {
-    int chunkSizeInBuffer;
-    HgetReturnCode_t funcret = ERR_TCPIPUNAPI_OK;
-
-    currentChunkSize = GetNextChunkSize();
-
-	if (contentLength) {
-		blockSize = contentLength/25;
-		currentBlock = 0;
-	}
-
-    while(1) {
-        if(currentChunkSize == 0) {
-            funcret = GetInputByte(NULL); //Chunk data is followed by an extra CRLF
-            if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
-            funcret = GetInputByte(NULL);
-            if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
-            currentChunkSize = GetNextChunkSize();
-            if(currentChunkSize == 0) {
-                break;
-            }
-        }
+    if (isChunkedTransfer)
+        return chunkState == CHUNK_DONE;
+    return zeroContentLengthAnnounced || (contentLength != 0 && receivedLength >= contentLength);
+}
 
-        if(remainingInputData == 0) {
-            funcret = EnsureThereIsTcpDataAvailable();
-            if (funcret != ERR_TCPIPUNAPI_OK)
-                return funcret;
-        }
 
-        chunkSizeInBuffer = currentChunkSize > remainingInputData ? remainingInputData : currentChunkSize;
-        receivedLength += chunkSizeInBuffer;
-        UpdateReceivingMessage();
-        if (!WriteContents(inputDataPointer, chunkSizeInBuffer))
-            return ERR_HGET_DISK_WRITE_ERROR;
-        inputDataPointer += chunkSizeInBuffer;
-        currentChunkSize -= chunkSizeInBuffer;
-        remainingInputData -= chunkSizeInBuffer;
-    }
-    return funcret;
+inline HgetReturnCode_t ProcessDirectData()
+{
+    receivedLength += remainingInputData;
+    currentBlock += remainingInputData;
+    UpdateReceivingMessage();
+    if (!WriteContents(inputDataPointer, remainingInputData))
+        return ERR_HGET_DISK_WRITE_ERROR;
+    ResetTcpBuffer();
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
-long GetNextChunkSize()
+//Walks the received block: the data goes to the save callback in one piece,
+//and the sizes, extensions, CRLFs and trailers are parsed as they come
+inline HgetReturnCode_t ProcessChunkedData()
 {
-    byte validHexDigit = 1;
-    char data;
-    long value = 0;
-
-    while(validHexDigit) {
-        if (GetInputByte(&data)!=ERR_TCPIPUNAPI_OK)
-            return 0; //bad hack, should not happen a lot anyway, and most servers do not used chunked transfers anyway
-        ToLowerCase(data);
-        if(data >= '0' && data <= '9') {
-            value = value*16 + data - '0';
-        } else if(data >= 'a' && data <= 'f') {
-            value = value*16 + data - 'a' + 10;
-        } else {
-            validHexDigit = 0;
+    int chunkSizeInBuffer;
+    byte data, digit;
+
+    while(remainingInputData && chunkState != CHUNK_DONE) {
+        if(chunkState == CHUNK_DATA) {
+            chunkSizeInBuffer = currentChunkSize > remainingInputData ? remainingInputData : (int)currentChunkSize;
+            receivedLength += chunkSizeInBuffer;
+            UpdateReceivingMessage();
+            if (!WriteContents(inputDataPointer, chunkSizeInBuffer))
+                return ERR_HGET_DISK_WRITE_ERROR;
+            inputDataPointer += chunkSizeInBuffer;
+            currentChunkSize -= chunkSizeInBuffer;
+            remainingInputData -= chunkSizeInBuffer;
+            if(currentChunkSize == 0)
+                chunkState = CHUNK_DATA_END;
+            continue;
         }
-    }
-
-    do {
-        if (GetInputByte(&data)!=ERR_TCPIPUNAPI_OK)
-            return 0; //bad hack, should not happen a lot anyway, and most servers do not used chunked transfers anyway
-    } while(data != 10);
 
-    return value;
+        data = *inputDataPointer++;
+        remainingInputData--;
+        switch(chunkState) {
+            case CHUNK_SIZE:
+                digit = data | 32;
+                if(data >= '0' && data <= '9') {
+                    digit = data - '0';
+                } else if(digit >= 'a' && digit <= 'f') {
+                    digit -= 'a' - 10;
+                } else {
+                    if(!chunkDigits)
+                        return ERR_HGET_BAD_CHUNK;
+                    chunkState = CHUNK_SIZE_LINE;
+                    if(data == '\n') {
+                        chunkDigits = 0;
+                        chunkState = currentChunkSize ? CHUNK_DATA : CHUNK_TRAILER;
+                    }
+                    break;
+                }
+                if(currentChunkSize > 0x07FFFFFL)
+                    return ERR_HGET_BAD_CHUNK;
+                currentChunkSize = currentChunkSize*16 + digit;
+                chunkDigits++;
+                break;
+            case CHUNK_SIZE_LINE:
+                if(data == '\n') {
+                    chunkDigits = 0;
+                    chunkState = currentChunkSize ? CHUNK_DATA : CHUNK_TRAILER;
+                }
+                break;
+            case CHUNK_DATA_END:
+                if(data == '\n')
+                    chunkState = CHUNK_SIZE;
+                else if(data != '\r')
+                    return ERR_HGET_BAD_CHUNK;
+                break;
+            case CHUNK_TRAILER:
+                if(data == '\n')
+                    chunkState = CHUNK_DONE;
+                else
+                    chunkState = data == '\r' ? CHUNK_TRAILER_END : CHUNK_TRAILER_LINE;
+                break;
+            case CHUNK_TRAILER_LINE:
+                if(data == '\n')
+                    chunkState = CHUNK_TRAILER;
+                break;
+            case CHUNK_TRAILER_END:
+                if(data != '\n')
+                    return ERR_HGET_BAD_CHUNK;
+                chunkState = CHUNK_DONE;
+                break;
+        }
+    }
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
@@ -845,30 +997,29 @@ inline bool CheckTcpipCapabilities()
 /* Functions Related to Network I/O */
 
 
-HgetReturnCode_t EnsureThereIsTcpDataAvailable()
+//Receives what is available without waiting for it; the time without
+//data is accumulated from one call to the next
+HgetReturnCode_t PollTcpData()
 {
     HgetReturnCode_t funcret;
-    ticksWaited = 0;
 
-	sysTimerHold = *SYSTIMER;
-	while(remainingInputData == 0) {
-		if (sysTimerHold != *SYSTIMER) {
-			++ticksWaited;
-			if(ticksWaited >= TICKS_TO_WAIT)
-                return ERR_HGET_TRANSFER_TIMEOUT;
-			sysTimerHold = *SYSTIMER;
-		}
-
-		funcret = ReadAsMuchTcpDataAsPossible();
-		if (funcret!=ERR_TCPIPUNAPI_OK)
-            return funcret;
-		if(remainingInputData == 0) {
-			if (!EnsureTcpConnectionIsStillOpen())
-                return ERR_HGET_CONN_LOST;
-            LetTcpipBreathe();
-		}
-	}
-	return ERR_TCPIPUNAPI_OK;
+    if(remainingInputData != 0)
+        return ERR_TCPIPUNAPI_OK;
+
+    ticksWaited += (uint)(*SYSTIMER - sysTimerHold);
+    sysTimerHold = *SYSTIMER;
+    if(ticksWaited >= TICKS_TO_WAIT)
+        return ERR_HGET_TRANSFER_TIMEOUT;
+
+    funcret = ReadAsMuchTcpDataAsPossible();
+    if (funcret!=ERR_TCPIPUNAPI_OK)
+        return funcret;
+    if(remainingInputData == 0) {
+        if (!EnsureTcpConnectionIsStillOpen())
+            return ERR_HGET_CONN_LOST;
+    } else
+        ticksWaited = 0;
+    return ERR_TCPIPUNAPI_OK;
 }
 
 
@@ -886,33 +1037,44 @@ inline bool EnsureTcpConnectionIsStillOpen()
 
 inline HgetReturnCode_t ReadAsMuchTcpDataAsPossible()
 {
+    unsigned int room = ReceiveBufferRoom();
+
     if(AbortIfEscIsPressed())
         return ERR_HGET_ESC_CANCELLED;
     reg.Bytes.B = conn;
-    reg.Words.DE = (int)(TcpInputData);
-    reg.Words.HL = TCP_BUFFER_SIZE;
+    if (room) {
+        reg.Words.DE = (int)(receiveBuffer);
+        reg.Words.HL = room;
+    } else {
+        reg.Words.DE = (int)(TcpInputData);
+        reg.Words.HL = TCP_BUFFER_SIZE;
+    }
     UnapiCall(codeBlock, TCPIP_TCP_RCV, &reg, REGS_MAIN, REGS_MAIN);
     if(reg.Bytes.A != 0)
         return ERR_TCPIPUNAPI_RECEIVE_ERROR;
 
     remainingInputData = reg.UWords.BC;
-    inputDataPointer = TcpInputData;
+    if (room) {
+        inputDataPointer = receiveBuffer;
+        if (remainingInputData)
+            receiveBuffer = NULL;
+    } else
+        inputDataPointer = TcpInputData;
 
     return ERR_TCPIPUNAPI_OK;
 }
 
 
-HgetReturnCode_t GetInputByte(byte *data)
+//Bytes that can be received into the application buffer: only contents
+inline unsigned int ReceiveBufferRoom()
 {
-    HgetReturnCode_t funcret = EnsureThereIsTcpDataAvailable();
-
-    if (funcret == ERR_TCPIPUNAPI_OK) {
-        if (data)
-            *data = *inputDataPointer;
-        inputDataPointer++;
-        remainingInputData--;
-    }
-    return funcret;
+    if (!receiveBuffer)
+        return 0;
+    if (!isChunkedTransfer)
+        return receiveBufferSize;
+    if (chunkState != CHUNK_DATA)
+        return 0;
+    return currentChunkSize < receiveBufferSize ? (unsigned int)currentChunkSize : receiveBufferSize;
 }
 
 
@@ -926,7 +1088,48 @@ inline bool CheckNetworkConnection()
 }
 
 
+HgetDnsEntry_t* FindDnsEntry()
+{
+    HgetDnsEntry_t *entry = dnsCache;
+
+    for (uint8_t i = 0; i < dnsCacheEntries; i++, entry++) {
+        if (entry->host[0] && strcmpi(entry->host, domainName) == 0)
+            return entry;
+    }
+    return NULL;
+}
+
+
+void StoreDnsEntry()
+{
+    HgetDnsEntry_t *entry;
+
+    if (!dnsCacheEntries || strlen(domainName) >= HGET_DNS_HOST_SIZE)
+        return;
+
+    entry = &dnsCache[dnsCacheNext];
+    dnsCacheNext = (dnsCacheNext + 1) % dnsCacheEntries;
+
+    strcpy(entry->host, domainName);
+    memcpy(entry->ip, TcpConnectionParameters->remoteIP, 4);
+    entry->timestamp = 0;
+}
+
+
+//Takes the address from the DNS cache and opens the connection, or starts
+//a query for it
 HgetReturnCode_t ResolveServerName()
+{
+    dnsEntryUsed = FindDnsEntry();
+    if (!dnsEntryUsed)
+        return QueryServerName();
+
+    memcpy(TcpConnectionParameters->remoteIP, dnsEntryUsed->ip, 4);
+    return OpenTcpConnection();
+}
+
+
+HgetReturnCode_t QueryServerName()
 {
     reg.Words.HL = (int)domainName;
     reg.Bytes.B = 0;
@@ -940,13 +1143,23 @@ HgetReturnCode_t ResolveServerName()
     else if(reg.Bytes.A != (byte)ERR_OK)
         return ERR_TCPIPUNAPI_UNKNOWN_ERROR;
 
-    do {
-        if (AbortIfEscIsPressed())
-            return ERR_HGET_ESC_CANCELLED;
+    hgetState = HGET_STATE_RESOLVE;
+    return ERR_HGET_IN_PROGRESS;
+}
+
+
+//Checks once if the DNS query is done, and then opens the connection
+HgetReturnCode_t PollServerName()
+{
+    if (AbortIfEscIsPressed())
+        return ERR_HGET_ESC_CANCELLED;
+
+    reg.Bytes.B = 0;
+    UnapiCall(codeBlock, TCPIP_DNS_S, &reg, REGS_MAIN, REGS_MAIN);
+    if (reg.Bytes.A == 0 && reg.Bytes.B == 1) {
         LetTcpipBreathe();
-        reg.Bytes.B = 0;
-        UnapiCall(codeBlock, TCPIP_DNS_S, &reg, REGS_MAIN, REGS_MAIN);
-    } while (reg.Bytes.A == 0 && reg.Bytes.B == 1);
+        return ERR_HGET_IN_PROGRESS;
+    }
 
     if(reg.Bytes.A != 0) {
         if(reg.Bytes.B == 2)
@@ -969,6 +1182,17 @@ HgetReturnCode_t ResolveServerName()
     TcpConnectionParameters->remoteIP[1] = reg.Bytes.H;
     TcpConnectionParameters->remoteIP[2] = reg.Bytes.E;
     TcpConnectionParameters->remoteIP[3] = reg.Bytes.D;
+    StoreDnsEntry();
+
+    return OpenTcpConnection();
+}
+
+
+//Starts opening the connection, PollTcpConnection waits for it
+HgetReturnCode_t OpenTcpConnection()
+{
+    hgetState = HGET_STATE_OPEN;
+
 #ifdef USE_TLS
 	if (useHttps) {
 		if (mustCheckCertificate)
@@ -984,12 +1208,6 @@ HgetReturnCode_t ResolveServerName()
 		TcpConnectionParameters->hostName =  0;
 	}
 
-    return ERR_TCPIPUNAPI_OK;
-}
-
-
-HgetReturnCode_t OpenTcpConnection()
-{
     reg.Words.HL = (int)TcpConnectionParameters;
     UnapiCall(codeBlock, TCPIP_TCP_OPEN, &reg, REGS_MAIN, REGS_MAIN);
     if(reg.Bytes.A == (byte)ERR_NO_FREE_CONN) {
@@ -1008,31 +1226,33 @@ HgetReturnCode_t OpenTcpConnection()
 
     ticksWaited = 0;
     sysTimerHold = *SYSTIMER;
-    do {
-        if (AbortIfEscIsPressed())
-            return ERR_HGET_ESC_CANCELLED;
+    return ERR_HGET_IN_PROGRESS;
+}
 
-        if (*SYSTIMER != sysTimerHold)
-        {
-            ticksWaited++;
-            if(ticksWaited >= TICKS_TO_WAIT)
-                return ERR_TCPIPUNAPI_CONNECTION_TIMEOUT;
-            sysTimerHold = *SYSTIMER;
-        }
 
-        reg.Bytes.B = conn;
-        reg.Words.HL = 0;
-        UnapiCall(codeBlock, TCPIP_TCP_STATE, &reg, REGS_MAIN, REGS_MAIN);
-        if ((reg.Bytes.A) == 0 && (reg.Bytes.B != 4))
-            LetTcpipBreathe();
-        else
-            break;
-    } while(1);
+//Checks once if the connection is established, and then prepares the request
+HgetReturnCode_t PollTcpConnection()
+{
+    if (AbortIfEscIsPressed())
+        return ERR_HGET_ESC_CANCELLED;
+
+    ticksWaited += (uint)(*SYSTIMER - sysTimerHold);
+    sysTimerHold = *SYSTIMER;
+    if(ticksWaited >= TICKS_TO_WAIT)
+        return ERR_TCPIPUNAPI_CONNECTION_TIMEOUT;
+
+    reg.Bytes.B = conn;
+    reg.Words.HL = 0;
+    UnapiCall(codeBlock, TCPIP_TCP_STATE, &reg, REGS_MAIN, REGS_MAIN);
+    if ((reg.Bytes.A) == 0 && (reg.Bytes.B != 4)) {
+        LetTcpipBreathe();
+        return ERR_HGET_IN_PROGRESS;
+    }
 
     if(reg.Bytes.A != 0)
 		return ERR_TCPIPUNAPI_CONNECTION_FAILED;
 
-    return ERR_TCPIPUNAPI_OK;
+    return StartHttpRequest();
 }
 
 
@@ -1046,30 +1266,28 @@ void CloseTcpConnection()
 }
 
 
-inline HgetReturnCode_t SendTcpData(byte* data, int dataSize)
+//Sends the next piece of sendPointer, ERR_HGET_IN_PROGRESS while there is
+//more left or the TCP buffer is full
+inline HgetReturnCode_t SendTcpData()
 {
-    do {
-        do {
-            reg.Bytes.B = conn;
-            reg.Words.DE = (int)data;
-            reg.Words.HL = dataSize > TCPOUT_STEP_SIZE ? TCPOUT_STEP_SIZE : dataSize;
-            reg.Bytes.C = 1;
-            UnapiCall(codeBlock, TCPIP_TCP_SEND, &reg, REGS_MAIN, REGS_AF);
-            if(reg.Bytes.A == ERR_BUFFER) {
-                LetTcpipBreathe();
-                reg.Bytes.A = ERR_BUFFER;
-            }
-        } while(reg.Bytes.A == ERR_BUFFER);
-        dataSize -= TCPOUT_STEP_SIZE;
-        data += reg.Words.HL;   //Unmodified since REGS_AF was used for output
-    } while(dataSize > 0 && reg.Bytes.A == 0);
+    reg.Bytes.B = conn;
+    reg.Words.DE = (int)sendPointer;
+    reg.Words.HL = sendRemaining > TCPOUT_STEP_SIZE ? TCPOUT_STEP_SIZE : sendRemaining;
+    reg.Bytes.C = 1;
+    UnapiCall(codeBlock, TCPIP_TCP_SEND, &reg, REGS_MAIN, REGS_AF);
+    if(reg.Bytes.A == ERR_BUFFER) {
+        LetTcpipBreathe();
+        return ERR_HGET_IN_PROGRESS;
+    }
 
     if(reg.Bytes.A == ERR_NO_CONN)
         return ERR_TCPIPUNAPI_NO_CONNECTION;
     else if(reg.Bytes.A != 0)
         return ERR_TCPIPUNAPI_SEND_ERROR;
-    else
-        return ERR_TCPIPUNAPI_OK;
+
+    sendPointer += reg.Words.HL;   //Unmodified since REGS_AF was used for output
+    sendRemaining -= reg.Words.HL;
+    return sendRemaining > 0 ? ERR_HGET_IN_PROGRESS : ERR_TCPIPUNAPI_OK;
 }
 
 
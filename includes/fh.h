@@ -14,7 +14,17 @@
 #define VERSIONAPP		"1.0.4"
 #define AUTHORAPP		"NataliaPC'2025"
 
-#define VRAM_START		0x1ba0
+// VRAM map (SCREEN 0, 80 columns):
+//   0x0000-0x077F  Name table 0, the one conio writes to
+//   0x0800-0x08EF  Blink table, shared by both name tables
+//   0x1000-0x17FF  Patterns
+//   0x1800-0x1FFF  Help window cache (mod_help.c)
+//   0x2000-0x277F  Second name table for the page moves (mod_pageFlip.h),
+//                  also the dialogs save area
+//   0x2780-        Names of the list items, up to the end of the 128K
+#define VRAM_HELP_CACHE	0x1800
+#define VRAM_BACK_TABLE	0x2000
+#define VRAM_START		0x2780
 
 extern const char *BASEURL;
 
@@ -63,7 +73,14 @@ extern uint8_t downloadStatus;
 extern const char *downloadMessage[];
 
 extern char *buff;
+#define BUFF_SIZE		512
+extern char scratch[];
+#define SCRATCH_SIZE	48
 extern ListItem_t *list_start;
+extern int16_t itemsCount;
+extern uint32_t vramAddress;
+extern bool listComplete;
+extern bool listCutShort;
 
 
 // ========================================================
@@ -80,5 +97,14 @@ void setSelectedLine(bool selected);
 void updateList();
 void printActivityLed(bool reset);
 void printList();
+bool formatItem(uint16_t index, uint8_t marquee, uint8_t *nameLen);
+void printLineCounter();
+void printFilterString(bool editing);
+void applyListFilter(char *text);
+void printStreamedList();
+void moveCursor(int16_t delta);
+void resetMarquee();
+uint16_t drainKey(char key);
 void printRequestData();
+uint16_t getCurrentIndex();
 ListItem_t* getCurrentItem();
@@ -2,7 +2,7 @@
 
  HGETLIB.h
 	 Header for HGET.c application interface
-	 Revision 0.4
+	 Revision 0.5
 
 				Oduvaldo Pavan Junior 09/2020 v0.1 - 0.4
 
@@ -11,6 +11,27 @@
 				Oduvaldo Pavan Junior 07/2019 v1.3
 
 	 HGET Library history:
+	 Version 0.5 - the application can provide a table to cache the DNS
+		 results (hgetSetDnsCache). A cached address that fails to connect is
+		 resolved again once. Also, a kept alive connection that was closed while
+		 idle, or that fails on the next request, is reopened once for that
+		 request without disabling keep-alive for the following ones. A
+		 connection to a different server is closed before opening the new one.
+		 The response headers are scanned from the received block instead of byte
+		 by byte, and the chunked bodies are decoded per block too, failing with
+		 ERR_HGET_BAD_CHUNK on a malformed chunk instead of truncating it. hget
+		 can be split in hgetBegin (prepares the request), hgetStep (does one
+		 step without waiting: DNS query, connection, request, received headers
+		 or contents, returns ERR_HGET_IN_PROGRESS until the contents are
+		 complete) and hgetEnd, so the application can do other work during the
+		 whole request. With hgetSetReceiveBuffer the data callback can have the
+		 next block received in its own buffer. The request is sent with a single
+		 TCP send, and the application can add its own headers to it
+		 (hgetAddHeader, hgetClearHeaders). A 206 response to a Range request
+		 reports where its contents start (hgetGetRangeStart), and
+		 hgetGetStatusCode returns the last status. hgetWatchHeader hands the
+		 contents of a response header to the application.
+
 	 Version 0.4 - some Internet Service Providers have a heavy hand on open
 		 connections, so a keep-alive connection might be terminated by the ISP
 		 (not the server) if it is idle for a while after the last GET request was
@@ -99,10 +120,23 @@ enum HgetReturnCodes_enum {
 	ERR_HGET_AUTH_REQUESTED_BUT_NO_CREDENTIALS_PROVIDED, //31
 	ERR_HGET_TRANSFER_TIMEOUT, //32
 	ERR_HGET_CONN_LOST, //33
-	ERR_HGET_INVALID_BUFFER //34
+	ERR_HGET_INVALID_BUFFER, //34
+	ERR_HGET_BAD_CHUNK, //35
+	ERR_HGET_IN_PROGRESS //36
 };
 typedef unsigned char HgetReturnCode_t;
 
+// Room for the extra request headers (hgetAddHeader)
+#define HGET_HEADERS_SIZE	256
+
+// DNS cache entry, the table is owned by the application
+#define HGET_DNS_HOST_SIZE	48
+typedef struct {
+	char     host[HGET_DNS_HOST_SIZE];	// Empty: unused entry
+	uint8_t  ip[4];
+	uint32_t timestamp;					// Not used by the library, set to 0 when resolved
+} HgetDnsEntry_t;
+
 typedef struct {
 	uint8_t specVersionMain;
 	uint8_t specVersionSec;
@@ -116,13 +150,24 @@ typedef struct {
 HgetReturnCode_t hgetinit(unsigned int addressforbuffer);
 void hgetfinish(void);
 void hgetSetUserAgent(const char* userAgent);
+void hgetClearHeaders();
+bool hgetAddHeader(const char* name, const char* value);
 #ifdef USE_TLS
 #warning "hget function prototype with TLS support!"
 HgetReturnCode_t hget(char* url, int progress_callback, bool checkcertificateifssl, bool checkhostnameifssl, int data_write_callback, int content_size_callback, bool enableKeepAlive);
+HgetReturnCode_t hgetBegin(char* url, int progress_callback, bool checkcertificateifssl, bool checkhostnameifssl, int data_write_callback, int content_size_callback, bool enableKeepAlive);
 #else
 HgetReturnCode_t hget(char* url, int progress_callback, int data_write_callback, int content_size_callback, bool enableKeepAlive);
+HgetReturnCode_t hgetBegin(char* url, int progress_callback, int data_write_callback, int content_size_callback, bool enableKeepAlive);
 #endif
+HgetReturnCode_t hgetStep();
+void hgetEnd();
+void hgetSetReceiveBuffer(unsigned char* buffer, unsigned int size);
 void hgetcancel();
+int hgetGetStatusCode();
+long hgetGetRangeStart();
+void hgetWatchHeader(char* title, char* value, unsigned char size);
+void hgetSetDnsCache(HgetDnsEntry_t *cache, uint8_t entries);
 
 bool net_waitConnected(uint16_t timeout_ticks);
 bool net_getDriverInfo(void *codeBlock, UnapiDriverInfo_t *info);
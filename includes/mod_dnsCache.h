@@ -0,0 +1,27 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "hgetlib.h"
+
+
+// ========================================================
+// Host addresses resolved by hget, kept in FHDNS.DAT next to FH.COM.
+// File layout: magic + HgetDnsEntry_t[DNSCACHE_ENTRIES]
+
+#define DNSCACHE_MAGIC			"FHD1"
+#define DNSCACHE_FILENAME		"FHDNS.DAT"
+#define DNSCACHE_PATH_SIZE		(64 + 13)
+#define DNSCACHE_ENTRIES		4
+#define DNSCACHE_TTL			(24*60)		// Minutes
+
+
+// ========================================================
+void dnsCacheInit();
+void dnsCacheRefresh();
+void dnsCacheSave();
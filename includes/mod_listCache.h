@@ -0,0 +1,46 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "structs.h"
+
+
+// ========================================================
+// The downloaded lists are kept in FHLSTn.LST files next to FH.COM.
+// File layout:
+//   ListCacheHeader_t
+//   Pages: ListCacheBlock_t + ListItem_t[count] + names (as stored in VRAM)
+
+#define LISTCACHE_MAGIC			"FHL2"
+#define LISTCACHE_KEY_SIZE		160
+#define LISTCACHE_PATH_SIZE		(64 + 13)
+#define LISTCACHE_SLOTS			16
+#define LISTCACHE_TTL_DEFAULT	60		// Minutes
+
+typedef struct {
+	char     magic[4];
+	uint32_t timestamp;					// Minutes (see getTimestamp())
+	uint32_t dataSize;					// Bytes of valid pages after the header
+	uint16_t itemsCount;
+	bool     complete;
+	char     key[LISTCACHE_KEY_SIZE];	// URL of the first page
+} ListCacheHeader_t;
+
+typedef struct {
+	uint16_t count;
+	uint32_t namesSize;
+} ListCacheBlock_t;
+
+extern uint16_t listCacheTTL;
+
+
+// ========================================================
+void listCacheInit();
+void listCacheSelect(char *url);
+bool listCacheLoad();
+void listCacheSave(uint16_t pageStart, uint32_t pageVramAddress);
@@ -0,0 +1,22 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+
+
+// ========================================================
+// First row of the list for every initial character (A-Z, 0-9), taken
+// from the names while they are copied to VRAM.
+
+#define LISTJUMP_BUCKETS	36
+#define LISTJUMP_NONE		0xffff
+
+
+// ========================================================
+void listJumpTruncate(uint16_t count);
+void listJumpScan(char *names, uint16_t size);
+uint16_t listJumpRow(char c);
@@ -0,0 +1,40 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "structs.h"
+
+
+// ========================================================
+// Last lists seen (panel, MSX target and search), kept in mapper segments
+// as a stream of its ListItem_t table followed by its names blob.
+
+#define LISTLRU_ENTRIES			4
+#define LISTLRU_MAX_SEGMENTS	8
+#define LISTLRU_BOUNCE_ITEMS	16
+#define LISTLRU_EMPTY			0xff
+
+typedef struct {
+	ReqType_t *type;
+	ReqMSX_t  *msx;
+	char       search[SEARCH_MAX_SIZE+1];
+	uint16_t   itemsCount;
+	uint32_t   namesSize;
+	bool       complete;
+	uint8_t    age;							// 0: most recent, LISTLRU_EMPTY: unused
+	uint8_t    segCount;
+	uint8_t    segs[LISTLRU_MAX_SEGMENTS];	// Index in the segments pool
+} ListLRUEntry_t;
+
+
+// ========================================================
+void listLRUInit();
+void listLRURelease();
+void listLRUStore();
+void listLRUSelect();
+bool listLRULoad();
@@ -0,0 +1,36 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "structs.h"
+
+
+// ========================================================
+// The ListItem_t table fills the TPA heap first and spills into MSX-DOS 2
+// mapper segments, that are paged in at page 2 only while they are accessed.
+// Nothing living in page 2 (heap buffers) can be used during that access.
+
+#define LISTSTORE_PAGE				2
+#define LISTSTORE_WINDOW			((ListItem_t*)0x8000)
+#define LISTSTORE_SEGMENT_SIZE		0x4000
+#define LISTSTORE_SEGMENT_ITEMS		(LISTSTORE_SEGMENT_SIZE / sizeof(ListItem_t))
+#define LISTSTORE_MAX_SEGMENTS		14
+#define LISTSTORE_MAX_ITEMS			32767
+#define LISTSTORE_STAGE_ITEMS		16
+
+
+// ========================================================
+void listStoreInit();
+void listStoreRelease();
+void listStoreReset(ListItem_t *tpaStart, uint16_t tpaCapacity);
+bool listStoreAppend(ListItem_t *items, uint16_t count);
+void listStoreTruncate(uint16_t count);
+ListItem_t* listStoreGet(uint16_t index);
+uint16_t listStoreCount();
+void* listStoreTpaEnd();
+ListItem_t* listStoreTpaFree(uint16_t *count);
@@ -0,0 +1,55 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "structs.h"
+#include "mod_listStore.h"
+
+
+// ========================================================
+// Rows shown in the panel. When active, the view is an index of the list
+// store positions kept in its own mapper segments; otherwise the rows are
+// the list store items as they are. It holds the filtered and sorted rows.
+
+#define LISTVIEW_SEGMENT_ENTRIES	(LISTSTORE_SEGMENT_SIZE / sizeof(uint16_t))
+#define LISTVIEW_MAX_SEGMENTS		((LISTSTORE_MAX_ITEMS + LISTVIEW_SEGMENT_ENTRIES - 1) / LISTVIEW_SEGMENT_ENTRIES)
+#define LISTVIEW_BATCH				32
+#define LISTVIEW_NAME_MAX			128
+
+#define LISTVIEW_SORT_NONE			0
+#define LISTVIEW_SORT_NAME_ASC		1
+#define LISTVIEW_SORT_NAME_DESC		2
+#define LISTVIEW_SORT_SIZE_ASC		3
+#define LISTVIEW_SORT_SIZE_DESC		4
+#define LISTVIEW_SORT_MODES			5
+#define LISTVIEW_SORT_SEGMENTS		4
+#define LISTVIEW_SORT_RECORDS		(LISTSTORE_SEGMENT_SIZE / sizeof(SortRecord_t))
+#define LISTVIEW_SORT_BATCH			16
+#define LISTVIEW_SORT_KEY			8			// Name chars in a key
+#define LISTVIEW_SORT_TIE			0x8000		// Index mark: same key as the previous row while sorting
+
+typedef struct {
+	uint32_t hi;				// Sort key: unsigned order of hi, lo and index
+	uint32_t lo;
+	uint16_t index;				// List store index
+} SortRecord_t;
+
+extern bool listViewActive;
+extern uint16_t listViewCount;
+extern char listViewFilter[];
+extern uint8_t listViewSort;
+
+
+// ========================================================
+void listViewInit();
+void listViewRelease();
+void listViewReset();
+bool listViewSetFilter(char *text);
+bool listViewSetSort(uint8_t mode);
+uint16_t listViewIndex(uint16_t row);
+ListItem_t* listViewGet(uint16_t row);
@@ -0,0 +1,23 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include "mod_pageFlip.h"
+
+
+// ========================================================
+// Screen rows under a dialog, saved to the back name table before it is
+// drawn and copied back when it is closed. The names are kept at the same
+// offset they have in the front table, the blink bytes in its header rows.
+
+#define OVERLAY_NAMES_SAVE		PAGEFLIP_BACK_TABLE
+#define OVERLAY_BLINK_SAVE		PAGEFLIP_BACK_TABLE
+
+
+// ========================================================
+void overlaySave(uint8_t y, uint8_t height);
+void overlayRestore();
@@ -0,0 +1,41 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+#include "fh.h"
+
+
+// ========================================================
+// Two name tables for the page moves: the one shown (pageFlipTable) and a
+// hidden one. The page next to the current one (in the direction of the last
+// move) is drawn in the hidden table while idle, and a page move only points
+// R#2 to it and swaps their roles. The panel rows are written to the shown
+// table; the header and footer rows to both, once the hidden one holds a copy
+// of them. conio only writes to table 0, so the dialogs call pageFlipHome()
+// first. The blink table is shared by both.
+
+#define PAGEFLIP_HOME_TABLE		0x0000
+#define PAGEFLIP_BACK_TABLE		VRAM_BACK_TABLE
+#define PAGEFLIP_REG2(table)	(((table) >> 10) | 0x03)
+#define PAGEFLIP_HIDDEN_TABLE	(pageFlipTable ^ (PAGEFLIP_HOME_TABLE ^ PAGEFLIP_BACK_TABLE))
+#define PAGEFLIP_HEADER_SIZE	((PANEL_FIRSTY-1)*80)
+#define PAGEFLIP_FOOTER_POS		(PANEL_LASTY*80)
+#define PAGEFLIP_FOOTER_SIZE	(2*80)
+#define PAGEFLIP_NONE			-1
+
+extern uint16_t pageFlipTable;
+
+
+// ========================================================
+void pageFlipInvalidate();
+void pageFlipIdle(int16_t top);
+void pageFlipShow(int16_t top);
+void pageFlipHome();
+void pageFlipPutLine(uint8_t x, uint8_t y, uint16_t len, char *text);
+void pageFlipPutStr(uint8_t x, uint8_t y, char *str);
+void pageFlipPutByte(uint16_t pos, uint8_t value);
@@ -0,0 +1,28 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// Panel scroll and VRAM to VRAM copies. The bytes are moved by the V9958
+// command engine (HMMM with the R#25 CMD bit set) when it is faster than
+// the CPU copy, which moves a whole scroll through one static buffer.
+
+#define PANELSCROLL_CMD_BIT		0x40
+#define PANELSCROLL_TEST_LOOPS	8
+
+extern bool panelScrollVDP;
+
+
+// ========================================================
+void panelScrollInit();
+void panelScrollRelease();
+void panelScrollCopy(uint16_t src, uint16_t dst, uint16_t size);
+void panelScrollUp();
+void panelScrollDown();
@@ -0,0 +1,26 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// RAM copy of the list panel rows (columns 2 to 79) as they are in the name
+// table shown, so a repaint only writes the rows that changed. Anything else drawing
+// over the panel must invalidate it.
+
+#define PANELSHADOW_POSX	2
+#define PANELSHADOW_WIDTH	78
+
+
+// ========================================================
+void panelShadowInvalidate();
+void panelShadowPutLine(uint8_t y, char *line);
+void panelShadowPutText(uint8_t y, uint8_t pos, uint8_t len, char *text);
+void panelShadowClear(uint8_t y);
+void panelShadowScroll(bool up);
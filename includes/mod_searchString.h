@@ -10,3 +10,4 @@
 
 
 void changeSearchString();
+void changeFilterString();
@@ -0,0 +1,37 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#pragma once
+#include <stdint.h>
+#include <stdbool.h>
+
+
+// ========================================================
+// UI animations timed in frames with JIFFY, the counter the BIOS H_TIMI
+// interrupt handler increments. The tasks run from the main code when it
+// calls uiTasksRun(), each one at most once per call: late tasks are not
+// caught up, they just run on the next frame they are checked.
+
+#define UITASK_MARQUEE		0
+#define UITASK_LED			1
+#define UITASKS_COUNT		2
+
+#define UITASK_MASK(id)		(1 << (id))
+#define UITASKS_ALL			0xff
+
+typedef struct {
+	void     (*run)();
+	uint8_t  period;			// Frames between runs
+	uint16_t next;				// JIFFY of the next run
+	bool     enabled;
+} UiTask_t;
+
+
+// ========================================================
+void uiTaskSet(uint8_t id, void (*run)(), uint8_t period);
+void uiTaskStart(uint8_t id, uint8_t delay);
+void uiTaskStop(uint8_t id);
+void uiTasksRun(uint8_t mask);
@@ -179,6 +179,7 @@ __sfr __at (0x99) IO_VDP2;
 #define H_NMI		0xfdd6	// (...) At the beginning of non-maskable interrupts routine (Main-ROM at 0066h)
 #define EXTBIO		0xffca	// (...) Extended BIOS call
 #define RG8SAV		0xffe7	// (BYTE) Mirror Of VDP Register 8 (R#8)
+#define RG25SAV		0xfffa	// (BYTE) Mirror Of VDP Register 25 (R#25) (MSX2+)
 
 // MSX-DOS system variables
 
@@ -196,6 +197,7 @@ volatile __at (PUTPNT) uint16_t varPUTPNT;
 volatile __at (GETPNT) uint16_t varGETPNT;
 volatile __at (MODE)   uint8_t  varMODE;
 volatile __at (JIFFY)  uint16_t varJIFFY;
+volatile __at (RG25SAV) uint8_t varRG25SAV;
 volatile __at (H_TIMI) uint16_t varHTIMI;
 volatile __at (FORCLR) uint16_t varFORCLR;
 volatile __at (BAKCLR) uint16_t varBAKCLR;
@@ -26,6 +26,21 @@ void setVDP_Write(uint32_t vram) __sdcccall(1);
 void msx2_copyToVRAM(uint16_t memory, uint32_t vram, uint16_t size) __sdcccall(0);
 void msx2_copyFromVRAM(uint32_t vram, uint16_t memory, uint16_t size) __sdcccall(0);
 
+#define VDP_V9938		0
+#define VDP_V9958		2
+#define VDP_HMMM		0xd0
+#define VDP_ARG_DIX		0x04
+typedef struct {
+	uint16_t sx, sy;
+	uint16_t dx, dy;
+	uint16_t nx, ny;
+	uint8_t  clr, arg, cmd;
+} VDP_Command_t;
+uint8_t vdp_getVersion() __sdcccall(1);
+void vdp_setRegister(uint8_t reg, uint8_t value) __sdcccall(1);
+void vdp_waitCommand() __sdcccall(1);
+void vdp_runCommand(VDP_Command_t *cmd) __sdcccall(1);
+
 char* formatSize(char *dst, uint16_t size);
 void memncpy(char *dst, char *src, char c, uint16_t size);
 void fillBlink(uint8_t x, uint8_t y, uint8_t lines, uint8_t len, bool enabled);
@@ -33,6 +48,7 @@ void putstrxy(uint8_t x, uint8_t y, char *str);
 uint8_t scanf(char *str, uint16_t maxLen);
 char* strReplaceChar(char *str, char find, char replace);
 void waitKey();
+uint32_t getTimestamp();
 
 
 #define MODE_ANK		0
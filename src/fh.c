@@ -24,12 +24,22 @@
 #include "mod_commandLine.h"
 #include "mod_help.h"
 #include "mod_disposable.h"
+#include "mod_listStore.h"
+#include "mod_listCache.h"
+#include "mod_listLRU.h"
+#include "mod_listView.h"
+#include "mod_listJump.h"
+#include "mod_panelScroll.h"
+#include "mod_panelShadow.h"
+#include "mod_pageFlip.h"
+#include "mod_uiTasks.h"
+#include "mod_dnsCache.h"
 #ifdef _DEBUG_
 	#include "test.h"
 #endif
 
 // ========================================================
-const char *BASEURL = "http://api.file-hunter.com/index4.php?base=1BA0&type=%s&msx=%s&char=%s&download=";
+const char *BASEURL = "http://api.file-hunter.com/index4.php?base=2780&type=%s&msx=%s&char=%s&download=";
 
 const ReqType_t reqType[] = {
 	{"", ""},
@@ -83,6 +93,7 @@ uint8_t originalBAKCLR;
 uint8_t originalBDRCLR;
 
 char *buff;
+char scratch[SCRATCH_SIZE];		// Short strings: heap_top is over the stack while a list is received
 Panel_t *currentPanel = &panels[PANEL_FIRST];
 int16_t itemsCount;
 int16_t topLine, currentLine;
@@ -90,22 +101,37 @@ int16_t topLine, currentLine;
 #define MARQUEE_FIRST			200
 #define MARQUEE_STEP			6
 #define MARQUEE_LEN_OFFSET		20
-uint8_t countDownMarquee;
+#define MAX_NAME_SIZE			70
+#define ITEM_POS_LOAD			67
+#define ITEM_POS_SIZE			78
 uint8_t marqueePos = 0;
 uint8_t marqueeLen = 0;
+char marqueeName[80 + MAX_NAME_SIZE];	// Name being scrolled, padded with spaces
+uint8_t marqueeWidth;
 
 #define UNAPI_BUFFER_SIZE		1600
-#define BUFF_SIZE				200
 #define STACKPILE_SIZE			1024
 #define DOWNLOAD_LIMIT_ADDR		(varTPALIMIT - BUFF_SIZE - STACKPILE_SIZE)
 #define VRAM_LIMIT_ADDR			(131072L)
+#define LIST_PAGE_SIZE			200
+#define LIST_PREFETCH_LINES		PANEL_HEIGHT
+#define NAMES_RECEIVE_SIZE		4096
+#define LIST_TOTAL_HEADER		"X-Total-Count"
 extern char *unapiBuffer;
 char *user_agent;
 ListItem_t *list_start;
-ListItem_t *list_item;
-char *list_raw;
+ListItem_t pendingItem;			// ListItem_t split between two received chunks
+uint8_t pendingLen;
+char *receiveEnd;				// Where the next chunk is received in place
 bool structList;
+bool listComplete;				// No more pages to fetch for the current list
+bool listCutShort;				// A page of the current list failed or didn't fit
+char listTotal[8];				// Items of the whole list, as sent by the server
+uint32_t nameOffset;			// Added to the names of the page being downloaded
+bool listPainted;				// First page already painted while downloading
+uint16_t itemsReady;			// Items with its name already in VRAM
 uint32_t vramAddress;
+bool refreshList;				// Skip the disk cache in the next list update
 bool isDownloading = false;
 uint8_t downloadStatus;
 
@@ -136,18 +162,79 @@ inline bool isShiftKeyPressed()
 // ========================================================
 const char progressChar[] = {'\x1c', '\x1d'};
 uint8_t progress = 0;
+bool ledActivity;
 #define STATUS_PROGRESS_POS		1
+#define LED_STEP				4
 void printActivityLed(bool reset)
 {
-	if (reset) progress = sizeof(progressChar) - 1;
-	setByteVRAM(STATUS_PROGRESS_POS, progressChar[progress]);
+	if (reset) {
+		progress = sizeof(progressChar) - 1;
+		ledActivity = false;
+	}
+	pageFlipPutByte(STATUS_PROGRESS_POS, progressChar[progress]);
 	progress = (progress + 1) % sizeof(progressChar);
 }
 
+// The LED blinks at a steady rate while data is arriving, whatever the chunk size
+void ledTask()
+{
+	if (ledActivity) {
+		ledActivity = false;
+		printActivityLed(false);
+	}
+}
+
 void HTTPStatusUpdate(bool isChunked)
 {
 	isChunked;
-	printActivityLed(false);
+	ledActivity = true;
+	uiTasksRun(UITASK_MASK(UITASK_LED));
+}
+
+bool storeListItems(ListItem_t *items, uint16_t count)
+{
+	ListItem_t *item = items;
+	uint16_t i = count;
+
+	if (nameOffset) {
+		while (i--) {
+			(item++)->name += nameOffset;
+		}
+	}
+	if (!listStoreAppend(items, count)) {
+		downloadStatus = DOWNLOAD_LIST_TOO_LONG;
+		isDownloading = false;
+		hgetcancel();
+		return false;
+	}
+	return true;
+}
+
+// The next chunk is received straight into the free TPA area of the list
+// store, after the incomplete item, so its items don't need to be copied
+void receiveInPlace(char *tail)
+{
+	uint16_t count;
+	char *dest = (char*)listStoreTpaFree(&count);
+
+	if (!dest) return;
+	if (tail != dest) {
+		memcpy(dest, tail, pendingLen);
+	}
+	receiveEnd = dest + pendingLen;
+	hgetSetReceiveBuffer((unsigned char*)receiveEnd, count * sizeof(ListItem_t) - pendingLen);
+}
+
+// The names are received in the free TPA area too: blocks as large as the
+// TCP/IP stack has ready, each one sent to VRAM with a single address set
+void receiveNames()
+{
+	uint16_t count;
+	ListItem_t *dest = listStoreTpaFree(&count);
+
+	if (!dest) return;
+	count = count > NAMES_RECEIVE_SIZE / sizeof(ListItem_t) ? NAMES_RECEIVE_SIZE : count * sizeof(ListItem_t);
+	hgetSetReceiveBuffer((unsigned char*)dest, count);
 }
 
 void DataWriteCallback(char *rcv_buffer, int bytes_read)
@@ -155,39 +242,66 @@ void DataWriteCallback(char *rcv_buffer, int bytes_read)
 	if (!bytes_read || !isDownloading) return;
 
 	if (structList) {
-		if (list_raw + bytes_read > (char*)DOWNLOAD_LIMIT_ADDR) {
-			downloadStatus = DOWNLOAD_LIST_TOO_LONG;
-			isDownloading = false;
-			hgetcancel();
-			return;
+		char *end = rcv_buffer + bytes_read;
+		char *ptr;
+		uint8_t size;
+
+		// Recibido en su sitio: el ListItem_t incompleto esta justo delante
+		if (rcv_buffer == receiveEnd) {
+			rcv_buffer -= pendingLen;
+			pendingLen = 0;
+		}
+		receiveEnd = NULL;
+		hgetSetReceiveBuffer(NULL, 0);
+
+		// Completa el ListItem_t que quedo partido al final del chunk anterior
+		if (pendingLen) {
+			size = sizeof(ListItem_t) - pendingLen;
+			if (size > bytes_read) size = bytes_read;
+			memcpy(((char*)&pendingItem) + pendingLen, rcv_buffer, size);
+			pendingLen += size;
+			rcv_buffer += size;
+			if (pendingLen >= sizeof(uint32_t) && !pendingItem.name) {
+				rcv_buffer -= pendingLen - sizeof(uint32_t);	// Lo que sigue a la marca de final son strings
+				goto endOfList;
+			}
+			if (pendingLen < sizeof(ListItem_t)) return;
+			pendingLen = 0;
+			if (!storeListItems(&pendingItem, 1)) return;
 		}
-		memcpy(list_raw, rcv_buffer, bytes_read);
-		list_raw += bytes_read;
 
 		// Recorre el buffer recibido de la lista de ListItem_t
-		while ((char*)(list_item + 1) < list_raw) {
-			if (!*((uint32_t *)list_item)) {	// Si el ListItem_t no tiene nombre, es el final de la lista
-				char *ptr = ((char *)list_item) + sizeof(uint32_t);	// ajusta el puntero a la lista al principio de lista de strings
-				int16_t size = list_raw - ptr;	// Calcula si hay algo del inicio de la lista de strings que copiar a VRAM
-				if (size > 0) {					// Copia el inicio de la lista de strings a VRAM
-					msx2_copyToVRAM((uint16_t)ptr, vramAddress, size);
-					vramAddress += size;		// Ajusta la direccion de VRAM para la siguiente copia
-				}
-				list_raw -= size;				// Ajusta el buffer al final de la lista de ListItem_t para los chunks siguientes
-				structList = false;				// Define que ya solo quedan datos de la lista de strings
-				break;
-			}
-			++list_item;
+		ptr = rcv_buffer;
+		while (end - ptr >= sizeof(ListItem_t) && *((uint32_t*)ptr)) {
+			ptr += sizeof(ListItem_t);
 		}
-	} else {
-		if (vramAddress + bytes_read >= VRAM_LIMIT_ADDR) {
-			downloadStatus = DOWNLOAD_LIST_TOO_LONG;
-			isDownloading = false;
-			hgetcancel();
-		} else {								// copia el buffer recibido a VRAM
-			msx2_copyToVRAM((uint16_t)rcv_buffer, vramAddress, bytes_read);
-			vramAddress += bytes_read;
+		if (!storeListItems((ListItem_t*)rcv_buffer, (ptr - rcv_buffer) / sizeof(ListItem_t))) return;
+
+		// Si el ListItem_t no tiene nombre, es el final de la lista
+		if (end - ptr < sizeof(uint32_t) || *((uint32_t*)ptr)) {
+			pendingLen = end - ptr;				// Guarda el ListItem_t incompleto para el siguiente chunk
+			memcpy(&pendingItem, ptr, pendingLen);
+			receiveInPlace(ptr);
+			return;
 		}
+		rcv_buffer = ptr + sizeof(uint32_t);	// ajusta el puntero al principio de lista de strings
+
+	endOfList:
+		structList = false;						// Define que ya solo quedan datos de la lista de strings
+		bytes_read = end - rcv_buffer;			// Calcula si hay algo del inicio de la lista de strings que copiar a VRAM
+		if (!bytes_read) return;
+	}
+
+	if (vramAddress + bytes_read >= VRAM_LIMIT_ADDR) {
+		downloadStatus = DOWNLOAD_LIST_TOO_LONG;
+		isDownloading = false;
+		hgetcancel();
+	} else {									// copia el buffer recibido a VRAM
+		listJumpScan(rcv_buffer, bytes_read);
+		msx2_copyToVRAM((uint16_t)rcv_buffer, vramAddress, bytes_read);
+		vramAddress += bytes_read;
+		receiveNames();
+		printStreamedList();
 	}
 }
 
@@ -204,18 +318,67 @@ void formatURL(char *buff, uint16_t fileNum)
 	free(SEARCH_MAX_SIZE + 1);
 }
 
-void getRemoteList()
+void formatListURL(uint16_t offset)
 {
-	vramAddress = VRAM_START;
+	formatURL(buff, -1);
+	csprintf(scratch, "&offset=%u&limit=%u", offset, LIST_PAGE_SIZE);
+	strcat(buff, scratch);
+}
+
+void beginListTransfer()
+{
+	// Move buff over the room reserved above the list while it is being filled
+	heap_top = (void*)DOWNLOAD_LIMIT_ADDR;
+	initializeBuffers();
+}
+
+void endListTransfer()
+{
+	itemsReady = listStoreCount();
+	itemsCount = listViewActive ? listViewCount : itemsReady;
+	heap_top = listStoreTpaEnd();
+	initializeBuffers();
+}
+
+// Runs while a page is arriving: the cursor moves over the items already
+// painted and the UI animations go on. Other keys wait in the buffer.
+void transferIdle()
+{
+	char key;
+
+	while (itemsCount && varGETPNT != varPUTPNT) {
+		key = *((char*)varGETPNT);
+		if (key != KEY_UP && key != KEY_DOWN) break;
+		getch();
+		resetMarquee();
+		if (key == KEY_UP) {
+			moveCursor(-1 - (int16_t)drainKey(KEY_UP));
+		} else {
+			moveCursor(1 + drainKey(KEY_DOWN));
+		}
+	}
+	uiTasksRun(UITASKS_ALL);
+}
+
+void fetchListPage()
+{
+	uint16_t pageStart = listStoreCount();
+	uint32_t pageVramAddress = vramAddress;
+	char *url = buff;
+
 	downloadStatus = DOWNLOAD_OK;
 	isDownloading = true;
 	structList = true;
+	pendingLen = 0;
+	receiveEnd = NULL;
+	listTotal[0] = '\0';
+	nameOffset = vramAddress - VRAM_START;	// The server places the names of every page at VRAM_START
 
-	formatURL(buff, -1);
-	resetList();			// popHeap() + pushHeap()
+	beginListTransfer();
 
 #ifdef _DEBUG_
 	uint16_t i = TEST_SIZE, size = 1024, pos = 0, cnt;
+	url;
 	while (i) {
 		size += (rand() % 10) - 5;
 		if (i < size) {
@@ -230,21 +393,32 @@ void getRemoteList()
 		cnt = varJIFFY;
 		while (varJIFFY-cnt < 3) {
 			ASM_EI; ASM_HALT;
+			transferIdle();
 		}
 	}
 #else
 	net_waitConnected(60*10);	// Wait for connection (10 seconds on NTSC, 12 on PAL)
+	dnsCacheRefresh();
+	hgetWatchHeader(LIST_TOTAL_HEADER, listTotal, sizeof(listTotal));
 
-	HgetReturnCode_t ret = hget(
-		buff,						// URL
+	HgetReturnCode_t ret = hgetBegin(
+		url,						// URL
 		(int)HTTPStatusUpdate,		// progress_callback
 		(int)DataWriteCallback,		// data_write_callback
 		0,							// content_size_callback
-		false						// enableKeepAlive
+		true						// enableKeepAlive
 	);
+	if (ret == ERR_TCPIPUNAPI_OK) {
+		while ((ret = hgetStep()) == ERR_HGET_IN_PROGRESS) {
+			transferIdle();
+		}
+		hgetEnd();
+	}
 	if (ret != ERR_TCPIPUNAPI_OK)
 	{
-		resetList();
+		listStoreTruncate(pageStart);
+		listJumpTruncate(pageStart);
+		vramAddress = pageVramAddress;
 		if (downloadStatus == DOWNLOAD_OK) {
 			if (ret == ERR_HGET_ESC_CANCELLED)
 				downloadStatus = DOWNLOAD_CANCELLED;
@@ -255,14 +429,65 @@ void getRemoteList()
 #endif
 
 	isDownloading = false;
-	itemsCount = list_item - list_start;
+	endListTransfer();
+
+	// Only a server that tells the list total sends it by pages (an empty page ends it anyway)
+	listComplete = downloadStatus != DOWNLOAD_OK || !listTotal[0] || listStoreCount() == pageStart ||
+		listStoreCount() >= (uint16_t)atoi(listTotal);
+
+	if (downloadStatus != DOWNLOAD_OK) listCutShort = true;
+
+	printActivityLed(true);
+}
+
+void getRemoteList()
+{
+	vramAddress = VRAM_START;
+	listPainted = false;
+	itemsReady = 0;
+
+	formatListURL(0);
+	listCacheSelect(buff);
+	listLRUStore();			// Keep the outgoing list in memory
+	listLRUSelect();
+	resetList();			// popHeap() + pushHeap()
+	listCutShort = false;
+
+	// Restore the list from memory, or from the disk cache if it is recent enough
+	downloadStatus = DOWNLOAD_OK;
+	beginListTransfer();
+	bool cached = !refreshList && (listLRULoad() || listCacheLoad());
+	endListTransfer();
+	refreshList = false;
+
+	if (!cached) {
+		formatListURL(0);
+		fetchListPage();
+		if (downloadStatus == DOWNLOAD_OK) {
+			listCacheSave(0, VRAM_START);
+		}
+	}
 	if (!itemsCount && downloadStatus == DOWNLOAD_OK) {
 		downloadStatus = DOWNLOAD_EMPTY;
 	}
+}
 
-	heap_top = list_raw;
-	initializeBuffers();
-	printActivityLed(true);
+void getNextListPage()
+{
+	uint16_t pageStart = listStoreCount();
+	uint32_t pageVramAddress = vramAddress;
+
+	formatListURL(pageStart);
+	fetchListPage();
+
+	// Keep the items already loaded if the next page fails
+	if (downloadStatus != DOWNLOAD_OK) {
+		downloadStatus = DOWNLOAD_OK;
+		putch(0x07);
+	} else {
+		listCacheSave(pageStart, pageVramAddress);
+	}
+	printLineCounter();
 }
 
 
@@ -275,6 +500,7 @@ void clearBlinkList()
 #define UPDATING_POSY	11
 void printUpdatingListMessage()
 {
+	panelShadowInvalidate();
 	fillBlink(1,UPDATING_POSY, 3,80, true);
 	putstrxy(31, UPDATING_POSY+1, "Retrieving list...");
 }
@@ -285,12 +511,85 @@ void removeUpdateMessage()
 	fillBlink(1,UPDATING_POSY, 3,80, false);
 }
 
+#define FILTER_POSX		3
+#define FILTER_WIDTH	(2 + 7 + SEARCH_MAX_SIZE + 2)
+void printFilterString(bool editing)
+{
+	memset(buff, '\x17', FILTER_WIDTH);
+	buff[FILTER_WIDTH] = '\0';
+	if (editing || listViewActive) {
+		csprintf(scratch, "\x13 Filter:%s%s \x14", listViewFilter, editing ? "_" : "");
+		memcpy(buff, scratch, strlen(scratch));
+	}
+	pageFlipPutStr(FILTER_POSX,23, buff);
+}
+
+void jumpToRow(uint16_t row)
+{
+	if (row >= itemsCount) {
+		putch(0x07);
+		return;
+	}
+	setSelectedLine(false);
+	topLine = row;
+	if (topLine + PANEL_HEIGHT > itemsCount) {
+		topLine = itemsCount > PANEL_HEIGHT ? itemsCount - PANEL_HEIGHT : 0;
+	}
+	currentLine = row - topLine;
+	printList();
+}
+
+const char *sortName[] = { "", "Name A-Z", "Name Z-A", "Size 0-9", "Size 9-0" };
+#define SORT_POSX		62
+#define SORT_WIDTH		(2 + 5 + 8 + 2)
+void printSortMode()
+{
+	memset(buff, '\x17', SORT_WIDTH);
+	buff[SORT_WIDTH] = '\0';
+	if (listViewSort) {
+		csprintf(scratch, "\x13 Sort:%s \x14", sortName[listViewSort]);
+		memcpy(buff, scratch, strlen(scratch));
+	}
+	pageFlipPutStr(SORT_POSX,23, buff);
+}
+
+void applyListSort(uint8_t mode)
+{
+	setSelectedLine(false);
+	if (!listViewSetSort(mode)) {
+		putch(0x07);
+	}
+	itemsCount = listViewActive ? listViewCount : listStoreCount();
+	pageFlipInvalidate();
+	resetSelectedLine();
+	printList();
+}
+
+// The pages not downloaded yet are sorted in after the last one (menu_loop)
+void nextSortMode()
+{
+	applyListSort((listViewSort + 1) % LISTVIEW_SORT_MODES);
+}
+
+void applyListFilter(char *text)
+{
+	setSelectedLine(false);
+	if (!listViewSetFilter(text)) {
+		putch(0x07);
+	}
+	itemsCount = listViewActive ? listViewCount : listStoreCount();
+	pageFlipInvalidate();
+	resetSelectedLine();
+	printList();
+}
+
 void printLineCounter()
 {
-	csprintf(buff, "\x13 %u/%u \x14\x17\x17\x17\x17",
+	csprintf(buff, "\x13 %u/%u%s \x14\x17\x17\x17\x17",
 		itemsCount ? topLine+currentLine+1 : 0,
-		itemsCount);
-	putstrxy(35,23, buff);
+		itemsCount,
+		listComplete ? "" : "+");
+	pageFlipPutStr(35,23, buff);
 }
 
 void printTabs()
@@ -332,23 +631,22 @@ void resetSelectedLine()
 	currentLine = topLine = 0;
 }
 
-void printItem(uint8_t y, ListItem_t *item)
+// Builds in buff the panel line of the item, with its name scrolled marquee chars
+bool formatItem(uint16_t index, uint8_t marquee, uint8_t *nameLen)
 {
-	#define MAX_NAME_SIZE	70
-	#define ITEM_POS_LOAD	67
-	#define ITEM_POS_SIZE	78
+	ListItem_t *item = listStoreGet(index);
 
-	if (!item->name) return;
+	if (!item->name) return false;
 
 	// Add name
 	msx2_copyFromVRAM((uint32_t)item->name, (uint16_t)buff, 80);
 	buff[80] = '\0';
-	marqueeLen = strlen(buff);
-	if (marqueePos) {
-		memncpy(buff, &buff[marqueePos], '\0', MAX_NAME_SIZE);
+	*nameLen = strlen(buff);
+	if (marquee) {
+		memncpy(buff, &buff[marquee], '\0', MAX_NAME_SIZE);
 	}
 
-	uint8_t len = marqueeLen - marqueePos;
+	uint8_t len = *nameLen - marquee;
 	if (len > MAX_NAME_SIZE) {
 		len = MAX_NAME_SIZE;
 	}
@@ -357,26 +655,53 @@ void printItem(uint8_t y, ListItem_t *item)
 
 	// Add load method
 	if (item->loadMethod) {
-		csprintf(heap_top, " (%c)     ", item->loadMethod);
-		memncpy(&buff[ITEM_POS_LOAD], heap_top, '\0', 5);
+		memcpy(&buff[ITEM_POS_LOAD], " ( ) ", 5);
+		buff[ITEM_POS_LOAD+2] = item->loadMethod;
 	}
 
 	// Add size
-	formatSize(heap_top, item->size);
-	strcpy(&buff[ITEM_POS_SIZE-strlen(heap_top)], heap_top);
+	formatSize(scratch, item->size);
+	strcpy(&buff[ITEM_POS_SIZE-strlen(scratch)], scratch);
+	return true;
+}
 
-	putlinexy(2,y, 78, buff);
+void printItem(uint8_t y, uint16_t index)
+{
+	if (formatItem(index, marqueePos, &marqueeLen)) {
+		panelShadowPutLine(y, buff);
+	}
 }
 
 void resetMarquee()
 {
-	countDownMarquee = MARQUEE_FIRST;	// Reset marquee counter
-	marqueePos = 0;						// Reset marquee position
+	uiTaskStart(UITASK_MARQUEE, MARQUEE_FIRST);	// Restart marquee timing
+	marqueePos = 0;								// Reset marquee position
+}
+
+void marqueeTask()
+{
+	ListItem_t *item;
+
+	if (!itemsCount || marqueeLen <= MAX_NAME_SIZE) return;
+
+	if (marqueePos >= marqueeLen - MARQUEE_LEN_OFFSET) {
+		resetMarquee();
+		printCurrentLine();
+		return;
+	}
+	if (!marqueePos++) {
+		// Keep the full name in RAM while it scrolls
+		item = getCurrentItem();
+		memset(marqueeName, ' ', sizeof(marqueeName));
+		msx2_copyFromVRAM(item->name, (uint16_t)marqueeName, marqueeLen);
+		marqueeWidth = item->loadMethod ? ITEM_POS_LOAD : MAX_NAME_SIZE;
+	}
+	panelShadowPutText(PANEL_FIRSTY + currentLine, 0, marqueeWidth, &marqueeName[marqueePos]);
 }
 
 void printCurrentLine()
 {
-	printItem(PANEL_FIRSTY + currentLine, list_start + topLine + currentLine);
+	printItem(PANEL_FIRSTY + currentLine, getCurrentIndex());
 }
 
 void setSelectedLine(bool selected)
@@ -388,17 +713,18 @@ void setSelectedLine(bool selected)
 void printList()
 {
 	printLineCounter();
+	printFilterString(false);
+	printSortMode();
 
 	if (downloadStatus == DOWNLOAD_OK) {
-		ListItem_t *item = list_start + topLine;
+		uint16_t index = topLine;
 		uint8_t y = 5;
 
 		while (y <= PANEL_LASTY) {
-			if (item->name) {
-				printItem(y++, item);
-				++item;
+			if (index < itemsCount) {
+				printItem(y++, listViewIndex(index++));
 			} else {
-				_fillVRAM((y-1)*80, (PANEL_LASTY-y+1)*80, ' ');
+				panelShadowClear(y);
 				break;
 			}
 		}
@@ -406,28 +732,93 @@ void printList()
 	} else {
 		// Print error message
 		setSelectedLine(false);
-		putstrxy(2, PANEL_FIRSTY, downloadMessage[downloadStatus]);
+		panelShadowInvalidate();
+		pageFlipPutStr(2, PANEL_FIRSTY, downloadMessage[downloadStatus]);
 		putch(0x07);
 	}
 }
 
-void panelScrollUp()
+void printStreamedList()
+{
+	uint16_t count = listStoreCount();
+
+	// An item is ready when the name of the next one has started to arrive
+	while (itemsReady + 1 < count && listStoreGet(itemsReady + 1)->name <= vramAddress) {
+		++itemsReady;
+	}
+	if (itemsReady < PANEL_HEIGHT || listViewActive) return;
+
+	itemsCount = itemsReady;
+	if (listPainted) {
+		printLineCounter();
+	} else {
+		listPainted = true;
+		removeUpdateMessage();
+		printList();
+	}
+}
+
+// Consumes the copies of key waiting in the keyboard buffer (auto-repeat)
+uint16_t drainKey(char key)
 {
-	msx2_copyFromVRAM(0+(PANEL_FIRSTY)*80, (uint16_t)heap_top, (PANEL_HEIGHT-1)*80);
-	msx2_copyToVRAM((uint16_t)heap_top, 0+(PANEL_FIRSTY-1)*80, (PANEL_HEIGHT-1)*80);
-	_fillVRAM(0+(PANEL_LASTY-1)*80, 80, ' ');
+	uint16_t count = 0;
+
+	while (varGETPNT != varPUTPNT && *((char*)varGETPNT) == key) {
+		getch();
+		count++;
+	}
+	return count;
+}
+
+// Moves the cursor delta rows at once: the highlight, a one row scroll or a repaint
+void moveCursor(int16_t delta)
+{
+	int16_t row = topLine + currentLine + delta;
+	int16_t line;
+
+	if (row < 0) row = 0;
+	if (row >= itemsCount) row = itemsCount - 1;
+	line = row - topLine;
+
+	if (line >= 0 && line < PANEL_HEIGHT) {
+		if (line != currentLine) {
+			setSelectedLine(false);
+			currentLine = line;
+			setSelectedLine(true);
+		}
+	} else if (line == -1 && currentLine == 0) {
+		--topLine;
+		panelScrollDown();
+		printCurrentLine();
+	} else if (line == PANEL_HEIGHT && currentLine == PANEL_HEIGHT - 1) {
+		++topLine;
+		panelScrollUp();
+		printCurrentLine();
+	} else {
+		setSelectedLine(false);
+		currentLine = line < 0 ? 0 : PANEL_HEIGHT - 1;
+		topLine = row - currentLine;
+		printList();
+	}
+	printLineCounter();
 }
 
-void panelScrollDown()
+// Page moves: the new page, drawn in the hidden name table while idle, is shown.
+// The blink table is shared, so the selection bar moves once it is shown.
+void showPage(int16_t oldLine)
 {
-	msx2_copyFromVRAM(0+(PANEL_FIRSTY-1)*80, (uint16_t)heap_top, (PANEL_HEIGHT-1)*80);
-	msx2_copyToVRAM((uint16_t)heap_top, 0+(PANEL_FIRSTY)*80, (PANEL_HEIGHT-1)*80);
-	_fillVRAM(0+(PANEL_FIRSTY-1)*80, 80, ' ');
+	pageFlipShow(topLine);
+	if (oldLine != currentLine) {
+		textblink(1, PANEL_FIRSTY+oldLine, 80, false);
+		textblink(1, PANEL_FIRSTY+currentLine, 80, true);
+	}
+	printLineCounter();
 }
 
 void clearListArea()
 {
 	_fillVRAM(0+4*80, 18*80, ' ');
+	panelShadowInvalidate();
 }
 
 
@@ -437,18 +828,28 @@ void resetList()
 	heapPop();
 	heapPush();
 
-	list_start = list_item = (ListItem_t*)heap_top;
-	list_raw = heap_top;
+	list_start = (ListItem_t*)heap_top;
 	list_start->name = 0L;
+	pendingLen = 0;
+	listViewReset();
+	listJumpTruncate(0);
+	pageFlipInvalidate();
+	listStoreReset(list_start, (DOWNLOAD_LIMIT_ADDR - (uint16_t)heap_top) / sizeof(ListItem_t));
+}
+
+uint16_t getCurrentIndex()
+{
+	return listViewIndex(topLine + currentLine);
 }
 
 ListItem_t* getCurrentItem()
 {
-	return list_start + topLine + currentLine;
+	return listStoreGet(getCurrentIndex());
 }
 
 void updateList()
 {
+	pageFlipHome();
 	ASM_EI; ASM_HALT;
 	clearBlinkList();
 	resetSelectedLine();
@@ -458,10 +859,18 @@ void updateList()
 
 	printUpdatingListMessage();
 
-	// Get remote list
+	// Get remote list (the first page could be already painted while downloading)
 	getRemoteList();
 
 	ASM_EI; ASM_HALT;
+	if (listPainted) {
+		if (downloadStatus == DOWNLOAD_OK) {
+			printLineCounter();
+			return;
+		}
+		clearBlinkList();
+		clearListArea();
+	}
 	removeUpdateMessage();
 	printList();
 }
@@ -471,6 +880,7 @@ void selectPanel(Panel_t *panel)
 	currentPanel = panel;
 	request.type = panel->type;
 
+	pageFlipHome();
 	ASM_EI; ASM_HALT;
 	printTabs();
 	printRequestData();
@@ -484,6 +894,7 @@ inline void nextTargetMSX()
 	if (request.msx->name[0] == 0) {
 		request.msx = &reqMSX[REQMSX_ALL];
 	}
+	pageFlipHome();
 	printRequestData();
 	updateList();
 }
@@ -492,6 +903,12 @@ inline void nextTargetMSX()
 // ========================================================
 void menu_loop()
 {
+	// UI animations
+	uiTaskSet(UITASK_MARQUEE, marqueeTask, MARQUEE_STEP);
+	uiTaskSet(UITASK_LED, ledTask, LED_STEP);
+	uiTaskStart(UITASK_LED, 0);
+	uiTaskStart(UITASK_MARQUEE, MARQUEE_FIRST);
+
 	// Initialize panel
 	selectPanel(currentPanel);
 
@@ -499,6 +916,8 @@ void menu_loop()
 	int8_t  newPanel = PANEL_NONE;
 	bool end = false;
 	bool shiftPressed;
+	int8_t pageDirection = 1;
+	int16_t oldLine;
 	char key;
 
 	while (!end) {
@@ -508,44 +927,26 @@ void menu_loop()
 			resetMarquee();
 			key = dos2_toupper(getch());
 			shiftPressed = isShiftKeyPressed();
+
+			// Shift+letter jumps to the first name starting with it
+			if (shiftPressed && key >= 'A' && key <= 'Z') {
+				if (itemsCount) jumpToRow(listJumpRow(key));
+				key = 0;
+			}
 			switch(key) {
 				case KEY_UP:
 					if (!itemsCount) break;
-					if (currentLine > 0) {
-						setSelectedLine(false);
-						--currentLine;
-						setSelectedLine(true);
-					} else {
-						if (topLine > 0) {
-							--topLine;
-							panelScrollDown();
-							printCurrentLine();
-						}
-					}
-					printLineCounter();
+					moveCursor(-1 - (int16_t)drainKey(KEY_UP));
 					break;
 				case KEY_DOWN:
 					if (!itemsCount) break;
-					if (currentLine + topLine + 1 < itemsCount) {
-						if (currentLine < PANEL_HEIGHT - 1) {
-							setSelectedLine(false);
-							++currentLine;
-							setSelectedLine(true);
-						} else {
-							if (topLine + currentLine + 1 < itemsCount) {
-								++topLine;
-								panelScrollUp();
-								printCurrentLine();
-							}
-						}
-						printLineCounter();
-					}
+					moveCursor(1 + drainKey(KEY_DOWN));
 					break;
 				case KEY_RIGHT:
 					if (!itemsCount) break;
+					oldLine = currentLine;
 					topLine += PANEL_HEIGHT;
 					if (topLine + PANEL_HEIGHT >= itemsCount || shiftPressed) {
-						setSelectedLine(false);
 						if (PANEL_HEIGHT > itemsCount) {
 							topLine = 0;
 							currentLine = itemsCount - 1;
@@ -553,21 +954,21 @@ void menu_loop()
 							currentLine = PANEL_HEIGHT - 1;
 							topLine = itemsCount - currentLine - 1;
 						}	
-						setSelectedLine(true);
 					}
-					printList();
+					pageDirection = 1;
+					showPage(oldLine);
 					break;
 				case KEY_LEFT:
 					if (!itemsCount) break;
+					oldLine = currentLine;
 					if (topLine + currentLine > 0 || shiftPressed) {
-						setSelectedLine(false);
 						topLine -= PANEL_HEIGHT;
 						if (topLine < 0 || shiftPressed) {
 							resetSelectedLine();
 						}
-						setSelectedLine(true);
 					}
-					printList();
+					pageDirection = -1;
+					showPage(oldLine);
 					break;
 				case KEY_TAB:
 					if (shiftPressed) {
@@ -601,6 +1002,23 @@ void menu_loop()
 				case '1':
 					showHelpWindow();
 					break;
+				case '2':
+					refreshList = true;
+					updateList();
+					break;
+				case '3':
+					if (!listStoreCount()) break;
+					changeFilterString();
+					break;
+				case '4':
+					if (!listStoreCount()) break;
+					nextSortMode();
+					break;
+				case '0':
+					if (!itemsCount) break;
+					for (key = '0'; key < '9' && listJumpRow(key) == LISTJUMP_NONE; key++);
+					jumpToRow(listJumpRow(key));
+					break;
 				case '5':
 				case KEY_SELECT:
 					if (!itemsCount) break;
@@ -620,18 +1038,19 @@ void menu_loop()
 				newPanel = PANEL_NONE;
 			}
 		}
-		if (itemsCount && marqueeLen > MAX_NAME_SIZE) {
-			if (!countDownMarquee) {
-				countDownMarquee = MARQUEE_STEP;
-				if (marqueePos < marqueeLen - MARQUEE_LEN_OFFSET) {
-					marqueePos++;
-				} else {
-					resetMarquee();
-				}
-				printItem(PANEL_FIRSTY + currentLine, list_start + topLine + currentLine);
-			} else {
-				countDownMarquee--;
-			}
+		// Fetch the next page when the cursor comes near the end of the loaded items
+		if (itemsCount && !listComplete && !listViewActive && topLine + currentLine + LIST_PREFETCH_LINES >= itemsCount) {
+			getNextListPage();
+		}
+		// A sorted list takes in the rest of the pages while idle, one per loop
+		if (listViewSort && !listComplete && !kbhit()) {
+			getNextListPage();
+			if (listComplete) applyListSort(listViewSort);
+		}
+		uiTasksRun(UITASKS_ALL);
+		// Draw the page the user will likely move to
+		if (itemsCount && !kbhit()) {
+			pageFlipIdle(topLine + pageDirection * PANEL_HEIGHT);
 		}
 	}
 }
@@ -658,6 +1077,15 @@ void restoreScreen()
 {
 	// Finish HGET library
 	hgetfinish();
+	dnsCacheSave();
+
+	// Free the mapper segments used by the list
+	listStoreRelease();
+	listLRURelease();
+	listViewRelease();
+
+	// Leave the VDP registers as they were
+	panelScrollRelease();
 
 	// Clear & restore original screen parameters & colors
 	__asm
@@ -0,0 +1,17 @@
+#include <stdint.h>
+#include "dos.h"
+#include "utils.h"
+
+
+// Minutes since 1980. Months are counted as 31 days: an approximation,
+// but it never goes backwards.
+uint32_t getTimestamp()
+{
+	SYSTEMDATE_t date;
+	SYSTEMTIME_t time;
+
+	getSystemDate(&date);
+	getSystemTime(&time);
+	return (uint32_t)((date.year - 1980) * 372 + (date.month - 1) * 31 + date.day - 1) * 1440L
+		+ time.hours * 60 + time.minutes;
+}
@@ -3,17 +3,21 @@ const unsigned char out_help_cmd_bin_zx0[] = {
   0x00, 0xe8, 0x0a, 0x55, 0x73, 0x61, 0x67, 0x65, 0x3a, 0x0a, 0x09, 0x46,
   0x48, 0x20, 0x5b, 0x2f, 0x48, 0x5d, 0xf6, 0x4f, 0x53, 0x20, 0x3c, 0x73,
   0x65, 0x61, 0x72, 0x63, 0x68, 0x3e, 0xe4, 0xa3, 0x4d, 0xb8, 0xc1, 0x6e,
-  0xea, 0xa2, 0x50, 0x28, 0x70, 0x61, 0xef, 0x65, 0x6c, 0xe7, 0x0a, 0xa1,
-  0xb8, 0xa9, 0x09, 0xff, 0x5e, 0x53, 0x68, 0x6f, 0x77, 0x20, 0x74, 0x68,
-  0x69, 0x73, 0x20, 0x68, 0xd3, 0x1f, 0x70, 0x20, 0x6d, 0x65, 0x73, 0x64,
-  0xf9, 0xc7, 0x78, 0x3a, 0xb6, 0x3e, 0x65, 0x74, 0xb9, 0xc1, 0xe7, 0x20,
-  0xde, 0x87, 0xf3, 0x74, 0x72, 0x69, 0x6e, 0x67, 0xf9, 0xb9, 0x4c, 0xe1,
-  0x31, 0x2f, 0x32, 0xfd, 0x38, 0x2b, 0x2f, 0x74, 0x75, 0x72, 0x62, 0x6f,
-  0x2d, 0x72, 0x3e, 0xaa, 0x20, 0xf9, 0x4d, 0x53, 0x58, 0x20, 0x71, 0x2b,
-  0x3f, 0x72, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0xa9, 0x0a, 0x95, 0xe1, 0x72,
-  0x6f, 0x6d, 0x2f, 0x64, 0x73, 0x6b, 0x2f, 0x63, 0x61, 0x73, 0x2f, 0x76,
-  0x67, 0x6d, 0xa6, 0xd8, 0xa7, 0xa6, 0x6c, 0x65, 0x74, 0x65, 0x64, 0xd8,
-  0xc6, 0xdf, 0xcb, 0xd1, 0xd9, 0xd9, 0x65, 0xe3, 0x2e, 0x48, 0x4c, 0x97,
-  0x66, 0x69, 0xe3, 0xcb, 0xf7, 0x6f, 0x72, 0x7f, 0xcd, 0xf9, 0xef, 0xeb,
-  0x13, 0xea, 0x6d, 0x89, 0x5a, 0xd5, 0x2e, 0x0a, 0x00, 0x55, 0x60
+  0xea, 0xa2, 0x50, 0x28, 0x70, 0x61, 0xe2, 0x65, 0x6c, 0xe6, 0x88, 0x54,
+  0xa0, 0x6d, 0x69, 0xef, 0x75, 0x74, 0x65, 0x73, 0xe3, 0x0a, 0x83, 0xb8,
+  0x8b, 0x09, 0xff, 0x5e, 0x53, 0x68, 0x6f, 0x77, 0x20, 0x74, 0x68, 0x69,
+  0x73, 0x20, 0x68, 0xb5, 0x7f, 0x70, 0x20, 0x6d, 0xc9, 0x46, 0xf9, 0xc7,
+  0x5a, 0x3a, 0xb6, 0x3e, 0x65, 0x74, 0xb9, 0xc1, 0xe7, 0x20, 0xde, 0x8e,
+  0xf3, 0x74, 0x72, 0x73, 0xfe, 0x67, 0xb9, 0x2e, 0x78, 0x31, 0x2f, 0x32,
+  0xfd, 0x4e, 0x2b, 0x2f, 0x74, 0x75, 0x72, 0x62, 0x6f, 0x2d, 0x72, 0x3e,
+  0xaa, 0x08, 0x3e, 0x4d, 0x53, 0x58, 0x20, 0x71, 0x0d, 0x4e, 0x72, 0x61,
+  0x74, 0x69, 0x6f, 0x6e, 0xa8, 0xa2, 0x50, 0x69, 0x72, 0x6f, 0x6d, 0x0e,
+  0x64, 0x73, 0x6b, 0x2f, 0x63, 0x61, 0x73, 0x2f, 0x76, 0x67, 0x6d, 0x3e,
+  0x50, 0x48, 0xb6, 0x6c, 0x65, 0xd3, 0x36, 0x64, 0x20, 0xa8, 0x3d, 0xa7,
+  0x97, 0xac, 0x8f, 0x05, 0x4c, 0x69, 0x1f, 0x7f, 0xc3, 0x97, 0x0d, 0x9b,
+  0xad, 0x6c, 0x69, 0x66, 0xb9, 0x5f, 0x6d, 0x41, 0xae, 0x28, 0x30, 0x3a,
+  0x64, 0xcf, 0x7b, 0x61, 0x62, 0x6c, 0x93, 0x29, 0x7f, 0x67, 0x6d, 0xdb,
+  0x27, 0xe3, 0x2e, 0x48, 0x4c, 0x8f, 0x33, 0x66, 0x69, 0xdb, 0x8d, 0xf7,
+  0x6f, 0x72, 0xff, 0x69, 0xf9, 0xef, 0x75, 0xad, 0xea, 0x6d, 0x89, 0xf6,
+  0xd5, 0x2e, 0x0a, 0x00, 0x55, 0x60
 };
@@ -0,0 +1,67 @@
+;===============================================================================
+; V9938/V9958 command engine helpers
+;
+
+;uint8_t vdp_getVersion() __sdcccall(1);
+; Returns the VDP ID from S#1 (0:V9938 2:V9958)
+_vdp_getVersion::
+	ld      a,#1
+	call    .setStatusReg
+	in      a,(0x99)
+	rrca
+	and     #0x1f
+	ld      b,a
+	xor     a
+	call    .setStatusReg
+	ei
+	ld      a,b
+	ret
+
+;void vdp_setRegister(uint8_t reg, uint8_t value) __sdcccall(1);
+_vdp_setRegister::
+	ld      b,a				; A = Param reg
+	ld      a,l				; L = Param value
+	di
+	out     (0x99),a
+	ld      a,b
+	or      #0x80
+	ei
+	out     (0x99),a
+	ret
+
+;void vdp_waitCommand() __sdcccall(1);
+; Waits for the command engine to finish (S#2 bit CE)
+_vdp_waitCommand::
+vdp_waitCommand::
+	ld      a,#2
+	call    .setStatusReg
+.wait:
+	in      a,(0x99)
+	rrca
+	jr      c,.wait
+	xor     a
+	call    .setStatusReg
+	ei
+	ret
+
+;void vdp_runCommand(VDP_Command_t *cmd) __sdcccall(1);
+; Writes R#32..R#46 from the command block and starts it
+_vdp_runCommand::
+	call    vdp_waitCommand	; HL = Param cmd
+	ld      a,#32			; R#17: indirect access from R#32 with autoincrement
+	di
+	out     (0x99),a
+	ld      a,#(17+128)
+	out     (0x99),a
+	ld      bc,#(15*256+0x9b)
+	otir
+	ei
+	ret
+
+; Selects the status register A (returns with interrupts disabled)
+.setStatusReg:
+	di
+	out     (0x99),a
+	ld      a,#(15+128)
+	out     (0x99),a
+	ret
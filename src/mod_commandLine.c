@@ -7,6 +7,7 @@
 #pragma codeseg DISPOSABLE
 
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 #include "msx_const.h"
 #include "structs.h"
@@ -16,6 +17,7 @@
 #include "utils.h"
 #include "fh.h"
 #include "mod_commandLine.h"
+#include "mod_listCache.h"
 
 
 // ========================================================
@@ -68,6 +70,10 @@ void checkArguments(char **argv, int argc)
 				argv[i][SEARCH_MAX_SIZE] = '\0';
 			}
 			strcpy(request.search.value, argv[i]);
+		} else
+		// List cache lifetime
+		if (cmd == 'T') {
+			listCacheTTL = atoi(argv[i]);
 		} else {
 			goto end;
 		}
@@ -14,6 +14,12 @@
 #include "utils.h"
 #include "fh.h"
 #include "mod_charPatterns.h"
+#include "mod_listStore.h"
+#include "mod_listCache.h"
+#include "mod_listLRU.h"
+#include "mod_listView.h"
+#include "mod_panelScroll.h"
+#include "mod_dnsCache.h"
 #include "hgetlib.h"
 #include "asm.h"
 
@@ -94,6 +100,12 @@ void checkPlatformSystem()
 		die("MSX-DOS 2.x or higher required!");
 	}
 
+	// Initialize the memory mapper used by the list store
+	listStoreInit();
+	listCacheInit();
+	listLRUInit();
+	listViewInit();
+
 	// Check TCP/IP UNAPI
 	char ret = hgetinit((uint16_t)unapiBuffer);
 	if (ret != ERR_TCPIPUNAPI_OK) {
@@ -110,6 +122,9 @@ void checkPlatformSystem()
 	// Format the user agent
 	formatUserAgent(msxdosVersion);
 
+	// Reuse the server addresses resolved in previous runs
+	dnsCacheInit();
+
 
 	// Set abort exit routine
 	dos2_setAbortRoutine((void*)abortRoutine);
@@ -137,7 +152,7 @@ inline void printHeader()
 	}
 
 	// Print footer
-	putstrxy(48,24, "F1:Help  F5:Download  RET:Search");
+	putstrxy(33,24, "F1:Help F3:Filter F4:Sort F5:Download RET:Search");
 }
 
 void initializeScreen()
@@ -156,4 +171,7 @@ void initializeScreen()
 
 	// Print header and footer
 	printHeader();
+
+	// Choose the panel scroll engine while the panel is empty
+	panelScrollInit();
 }
@@ -0,0 +1,85 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dos.h"
+#include "utils.h"
+#include "hgetlib.h"
+#include "mod_dnsCache.h"
+
+
+// ========================================================
+static char dnsFile[DNSCACHE_PATH_SIZE];
+static HgetDnsEntry_t entries[DNSCACHE_ENTRIES];
+static bool changed;
+
+
+// ========================================================
+// Loads the saved addresses and hands the table to hget
+void dnsCacheInit()
+{
+	char magic[4];
+	char *ptr;
+	FILEH fh;
+
+	// The file is placed in the FH.COM folder
+	if (dos2_getEnv("PROGRAM", dnsFile, DNSCACHE_PATH_SIZE - 13)) {
+		dnsFile[0] = '\0';
+	}
+	ptr = strrchr(dnsFile, '\\');
+	strcpy(ptr ? ptr + 1 : dnsFile, DNSCACHE_FILENAME);
+
+	memset(entries, 0, sizeof(entries));
+	fh = dos2_fopen(dnsFile, O_RDONLY);
+	if (fh < ERR_FIRST) {
+		if (dos2_fread(magic, 4, fh) != 4 || memcmp(magic, DNSCACHE_MAGIC, 4) ||
+			dos2_fread((char*)entries, sizeof(entries), fh) != sizeof(entries))
+		{
+			memset(entries, 0, sizeof(entries));
+		}
+		dos2_fclose(fh);
+	}
+	changed = false;
+	dnsCacheRefresh();
+
+	hgetSetDnsCache(entries, DNSCACHE_ENTRIES);
+}
+
+// Stamps the new addresses and forgets the expired ones
+void dnsCacheRefresh()
+{
+	HgetDnsEntry_t *entry = entries;
+	uint32_t now = getTimestamp();
+
+	for (uint8_t i = 0; i < DNSCACHE_ENTRIES; i++, entry++) {
+		if (!entry->host[0]) continue;
+		if (!entry->timestamp) {
+			entry->timestamp = now;
+			changed = true;
+		} else
+		if (now - entry->timestamp >= DNSCACHE_TTL) {
+			entry->host[0] = '\0';
+			changed = true;
+		}
+	}
+}
+
+void dnsCacheSave()
+{
+	FILEH fh;
+
+	dnsCacheRefresh();
+	if (!changed) return;
+
+	dos2_remove(dnsFile);
+	fh = dos2_fcreate(dnsFile, O_WRONLY, ATTR_ARCHIVE);
+	if (fh >= ERR_FIRST) return;
+	dos2_fwrite(DNSCACHE_MAGIC, 4, fh);
+	dos2_fwrite((char*)entries, sizeof(entries), fh);
+	dos2_fclose(fh);
+}
@@ -5,6 +5,7 @@
 	See LICENSE file.
 */
 #include <string.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include "msx_const.h"
 #include "structs.h"
@@ -15,6 +16,9 @@
 #include "fh.h"
 #include "hgetlib.h"
 #include "mod_downloadFiles.h"
+#include "mod_pageFlip.h"
+#include "mod_overlay.h"
+#include "mod_dnsCache.h"
 
 
 // ========================================================
@@ -23,6 +27,10 @@ static uint32_t downloadSize;
 static uint8_t downloadFileStatus;
 static uint32_t downloadedBytes;
 static bool firstChunk;
+static uint32_t resumeOffset;			// Size of the partial file being continued
+static uint16_t nameLineLen;			// Line with the name that precedes the file data
+static bool wholeFileSent;				// The server ignored the Range of a partial file
+static char contentRange[40];
 
 // ========================================================
 inline void printEnterFilename(ListItem_t *item)
@@ -47,11 +55,6 @@ inline void printEnterFilename(ListItem_t *item)
 	putstrxy(4, DOWNLOAD_POSY+4, buff);
 }
 
-inline void clearDownloadMessage()
-{
-	fillBlink(1,DOWNLOAD_POSY, DOWNLOAD_HEIGHT,80, false);
-}
-
 inline void printDownloadMessage()
 {
 	_fillVRAM(0+(DOWNLOAD_POSY-1)*80, DOWNLOAD_HEIGHT*80, ' ');
@@ -83,51 +86,160 @@ static void FileSizeUpdate(long contentSize)
 	downloadSize = contentSize;
 }
 
+static void cancelFileDownload(uint8_t status)
+{
+	downloadFileStatus = status;
+	hgetcancel();
+}
+
 static void FileWriteCallback(char *rcv_buffer, int bytes_read)
 {
+	long rangeStart;
+	char *total;
+
+	if (downloadFileStatus != DOWNLOAD_OK || wholeFileSent) return;
+
 	if (bytes_read) {
 		char *ptr = rcv_buffer;
 		if (firstChunk) {
 			firstChunk = false;
-			ptr = strchr(rcv_buffer, '\n') + 1;
-			bytes_read -= (ptr - rcv_buffer);
+			if (resumeOffset) {
+				rangeStart = hgetGetRangeStart();
+				if (rangeStart == (long)(nameLineLen + resumeOffset)) {
+					// Partial content: only the missing data, appended to the file.
+					// The file size is the range total without the name line.
+					total = strchr(contentRange, '/');
+					if (total && total[1] != '*') {
+						downloadSize = atol(total + 1) - nameLineLen;
+					} else {
+						downloadSize += resumeOffset;
+					}
+				} else if (rangeStart != -1) {
+					// Any other range would leave a hole or overlap in the file
+					cancelFileDownload(DOWNLOAD_FILE_ERROR);
+					return;
+				} else {
+					// The whole file is coming: the user decides whether the partial one goes
+					wholeFileSent = true;
+					hgetcancel();
+					return;
+				}
+			}
+			if (!resumeOffset) {
+				ptr = strchr(rcv_buffer, '\n') + 1;
+				bytes_read -= (ptr - rcv_buffer);
+			}
 		}
 		dos2_fwrite(ptr, bytes_read, fh);
 	}
 
 	downloadedBytes += bytes_read;
-	csprintf(heap_top, "%lu%%", downloadedBytes * 100L / downloadSize);
-	putstrxy(38,DOWNLOAD_POSY+4, heap_top);
+	csprintf(scratch, "%lu%%", downloadedBytes * 100L / downloadSize);
+	putstrxy(38,DOWNLOAD_POSY+4, scratch);
 }
 
-void downloadFileToDisk(ListItem_t *item)
+void downloadFileToDisk(uint16_t index)
 {
-	formatURL(buff, item-list_start);
+	formatURL(buff, index);
 
 	net_waitConnected(60*10);		// Wait for connection (10 seconds on NTSC, 12 on PAL)
+	dnsCacheRefresh();
+
+	// Ask only for the bytes missing in the partial file, past the name line
+	hgetClearHeaders();
+	if (resumeOffset) {
+		csprintf(scratch, "bytes=%lu-", nameLineLen + resumeOffset);
+		hgetAddHeader("Range", scratch);
+	}
+	hgetWatchHeader("Content-Range", contentRange, sizeof(contentRange));
 
 	if (hget(
 		buff,						// URL
 		(int)HTTPStatusUpdate,		// progress_callback
 		(int)FileWriteCallback,		// data_write_callback
 		(int)FileSizeUpdate,		// content_size_callback
-		false						// enableKeepAlive
+		true						// enableKeepAlive
 	) != ERR_TCPIPUNAPI_OK)
 	{
-		if (downloadFileStatus == DOWNLOAD_OK)
-			downloadFileStatus = DOWNLOAD_FILE_ERROR;
+		if (downloadFileStatus == DOWNLOAD_OK && !wholeFileSent) {
+			// Range Not Satisfiable: the file was already complete
+			downloadFileStatus = hgetGetStatusCode() == 416 ? DOWNLOAD_FILE_EXISTS : DOWNLOAD_FILE_ERROR;
+		}
+	}
+	hgetClearHeaders();
+}
+
+// An existing file shorter than the listed size is a download to be continued
+// (an empty one is written from the start). The server answers the Range
+// request with the missing part (206), or 416 when nothing is missing.
+static FILEH openPartialFile(char *filename, ListItem_t *item)
+{
+	RETDW size;
+	FILEH file = dos2_fopen(filename, O_WRONLY);
+
+	if (file >= ERR_FIRST) return ERR_FILEX;
+	size = dos2_fseek(file, 0, SEEK_END);
+	if (size < 0 || size >= (uint32_t)item->size * 1024) {
+		dos2_fclose(file);
+		return ERR_FILEX;
 	}
+	if (!size) return file;
+
+	// The response starts with a line holding the name as listed
+	msx2_copyFromVRAM((uint32_t)item->name, (uint16_t)buff, BUFF_SIZE);
+	buff[BUFF_SIZE-1] = '\0';
+	nameLineLen = strlen(buff) + 1;
+
+	resumeOffset = size;
+	downloadedBytes = size;
+	return file;
+}
+
+// The server can't continue the partial file: it is written again only if the user agrees
+static FILEH askRewriteFile(char *filename)
+{
+	FILEH file;
+	char key;
+
+	clearStatusLine();
+	putstrxy(4, DOWNLOAD_POSY+4, "The server can't continue the file. Download it again? (Y/N)");
+	do {
+		key = dos2_toupper(getch());
+	} while (key != 'Y' && key != 'N' && key != KEY_ESC);
+
+	if (key != 'Y') {
+		downloadFileStatus = DOWNLOAD_FILE_EXISTS;
+		return ERR_FILEX;
+	}
+	clearStatusLine();
+	csprintf(buff, "Downloading file \"%s\":", filename);
+	putstrxy(4, DOWNLOAD_POSY+4, buff);
+
+	dos2_remove(filename);
+	resumeOffset = 0;
+	downloadedBytes = 0;
+	wholeFileSent = false;
+	file = dos2_fcreate(filename, O_WRONLY, ATTR_ARCHIVE);
+	if (file >= ERR_FIRST) {
+		downloadFileStatus = DOWNLOAD_FILE_ERROR;
+	}
+	return file;
 }
 
 // ========================================================
 void downloadFile()
 {
-	ListItem_t *item = getCurrentItem();
+	uint16_t index = getCurrentIndex();
+	ListItem_t *item = malloc(sizeof(ListItem_t));
 	bool end;
 	char *filename = malloc(8+1+3+1);
 
+	memcpy(item, getCurrentItem(), sizeof(ListItem_t));	// The store returns a shared copy for mapped items
+
+	pageFlipHome();
 	ASM_EI; ASM_HALT;
 	setSelectedLine(false);
+	overlaySave(DOWNLOAD_POSY, DOWNLOAD_HEIGHT);
 
 	do {
 		printEnterFilename(item);
@@ -151,13 +263,26 @@ void downloadFile()
 			csprintf(buff, "Downloading file \"%s\":", filename);
 			putstrxy(4, DOWNLOAD_POSY+4, buff);
 
-			// Create file on disk
+			// Create file on disk, or continue a partial one
+			resumeOffset = 0;
+			wholeFileSent = false;
 			fh = dos2_fcreate(filename, O_WRONLY, ATTR_ARCHIVE);
+			if (fh == ERR_FILEX) {
+				fh = openPartialFile(filename, item);
+			}
 			if (fh < ERR_FIRST) {
 				firstChunk = true;
-				downloadFileToDisk(item);
+				downloadFileToDisk(index);
+				if (wholeFileSent) {
+					dos2_fclose(fh);
+					fh = askRewriteFile(filename);
+					if (fh < ERR_FIRST) {
+						firstChunk = true;
+						downloadFileToDisk(index);
+					}
+				}
 				printActivityLed(true);
-				dos2_fclose(fh);
+				if (fh < ERR_FIRST) dos2_fclose(fh);
 			} else {
 				switch (fh) {
 					case ERR_FILEX:	// File already exists
@@ -192,9 +317,9 @@ void downloadFile()
 	} while (!end);
 
 	ASM_EI; ASM_HALT;
-	clearDownloadMessage();
-	printList();
+	overlayRestore();
 	setSelectedLine(true);
 
 	free(8+1+3+1);
+	free(sizeof(ListItem_t));
 }
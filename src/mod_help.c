@@ -11,6 +11,9 @@
 #include "utils.h"
 #include "fh.h"
 #include "mod_help.h"
+#include "mod_pageFlip.h"
+#include "mod_panelScroll.h"
+#include "mod_overlay.h"
 
 
 // ========================================================
@@ -18,26 +21,34 @@ extern const unsigned char out_help_bin_zx0[];
 
 
 // ========================================================
-#define HELPWIN_POSY	6
+#define HELPWIN_POSY	PANEL_FIRSTY
 #define HELPWIN_SIZE	(*((uint16_t*)out_help_bin_zx0))
 #define HELPWIN_HEIGHT	(HELPWIN_SIZE/80)
+#define HELPWIN_CACHE	VRAM_HELP_CACHE
+
+static bool helpCached;
 
 
 
 // ========================================================
 void showHelpWindow()
 {
+	pageFlipHome();
 	setSelectedLine(false);
-	_fillVRAM(0+(HELPWIN_POSY-1)*80, HELPWIN_SIZE, ' ');
+	overlaySave(HELPWIN_POSY, HELPWIN_HEIGHT);
 	fillBlink(1,HELPWIN_POSY, HELPWIN_HEIGHT,80, true);
 
-	dzx0_standard(out_help_bin_zx0 + 2, heap_top);
-	msx2_copyToVRAM((uint16_t)heap_top, 0+(HELPWIN_POSY-1)*80, HELPWIN_SIZE);
+	// The help text is decompressed only the first time
+	if (!helpCached) {
+		dzx0_standard(out_help_bin_zx0 + 2, heap_top);
+		msx2_copyToVRAM((uint16_t)heap_top, HELPWIN_CACHE, HELPWIN_SIZE);
+		helpCached = true;
+	}
+	panelScrollCopy(HELPWIN_CACHE, 0+(HELPWIN_POSY-1)*80, HELPWIN_SIZE);
 
 	// Wait for a pressed key
 	waitKey();
 
-	_fillVRAM(0+(HELPWIN_POSY-1)*80, HELPWIN_SIZE, ' ');
-	fillBlink(1,HELPWIN_POSY, HELPWIN_HEIGHT,80, false);
-	printList();
+	overlayRestore();
+	setSelectedLine(true);
 }
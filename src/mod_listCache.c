@@ -0,0 +1,171 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "conio.h"
+#include "dos.h"
+#include "utils.h"
+#include "fh.h"
+#include "mod_listStore.h"
+#include "mod_listJump.h"
+#include "mod_listCache.h"
+
+
+// ========================================================
+#define CHUNK_ITEMS		(BUFF_SIZE / sizeof(ListItem_t))
+
+uint16_t listCacheTTL = LISTCACHE_TTL_DEFAULT;
+
+static char cacheFile[LISTCACHE_PATH_SIZE];
+static char *cacheName;						// Filename part of cacheFile
+static char cacheKey[LISTCACHE_KEY_SIZE];
+static ListCacheHeader_t header;
+
+
+// ========================================================
+void listCacheInit()
+{
+	char *ptr;
+
+	// The cache files are placed in the FH.COM folder
+	if (dos2_getEnv("PROGRAM", cacheFile, LISTCACHE_PATH_SIZE - 13)) {
+		cacheFile[0] = '\0';
+	}
+	ptr = strrchr(cacheFile, '\\');
+	cacheName = ptr ? ptr + 1 : cacheFile;
+}
+
+void listCacheSelect(char *url)
+{
+	uint8_t hash = 0;
+	char *ptr = url;
+
+	memset(cacheKey, 0, LISTCACHE_KEY_SIZE);
+	strncpy(cacheKey, url, LISTCACHE_KEY_SIZE - 1);
+
+	while (*ptr) {
+		hash = hash * 31 + *ptr++;
+	}
+	csprintf(cacheName, "FHLST%u.LST", hash % LISTCACHE_SLOTS);
+}
+
+bool listCacheLoad()
+{
+	ListCacheBlock_t block;
+	uint16_t size;
+	uint32_t names;
+	bool ok = false;
+	FILEH fh;
+
+	if (!listCacheTTL) return false;
+
+	fh = dos2_fopen(cacheFile, O_RDONLY);
+	if (fh >= ERR_FIRST) return false;
+
+	if (dos2_fread((char*)&header, sizeof(ListCacheHeader_t), fh) == sizeof(ListCacheHeader_t) &&
+		!memcmp(header.magic, LISTCACHE_MAGIC, 4) &&
+		!memcmp(header.key, cacheKey, LISTCACHE_KEY_SIZE) &&
+		getTimestamp() - header.timestamp < listCacheTTL)
+	{
+		while (listStoreCount() < header.itemsCount) {
+			if (dos2_fread((char*)&block, sizeof(ListCacheBlock_t), fh) != sizeof(ListCacheBlock_t)) goto end;
+
+			// Items, already pointing to its final VRAM address
+			while (block.count) {
+				size = block.count > CHUNK_ITEMS ? CHUNK_ITEMS : block.count;
+				if (dos2_fread(buff, size * sizeof(ListItem_t), fh) != size * sizeof(ListItem_t) ||
+					!listStoreAppend((ListItem_t*)buff, size)) goto end;
+				block.count -= size;
+			}
+
+			// Names
+			names = block.namesSize;
+			while (names) {
+				size = names > BUFF_SIZE ? BUFF_SIZE : names;
+				if (dos2_fread(buff, size, fh) != size) goto end;
+				listJumpScan(buff, size);
+				msx2_copyToVRAM((uint16_t)buff, vramAddress, size);
+				vramAddress += size;
+				names -= size;
+			}
+		}
+		ok = true;
+		listComplete = header.complete;
+	}
+
+end:
+	dos2_fclose(fh);
+	if (!ok) {
+		listStoreTruncate(0);
+		listJumpTruncate(0);
+		vramAddress = VRAM_START;
+	}
+	return ok;
+}
+
+void listCacheSave(uint16_t pageStart, uint32_t pageVramAddress)
+{
+	ListCacheBlock_t block;
+	uint16_t index, size, i;
+	uint16_t total = listStoreCount();
+	uint32_t vram;
+	FILEH fh;
+
+	if (!listCacheTTL || !total) return;
+
+	if (!pageStart) {
+		// First page: start a new file
+		dos2_remove(cacheFile);
+		fh = dos2_fcreate(cacheFile, O_RDWR, ATTR_ARCHIVE);
+		if (fh >= ERR_FIRST) return;
+		memcpy(header.magic, LISTCACHE_MAGIC, 4);
+		memcpy(header.key, cacheKey, LISTCACHE_KEY_SIZE);
+		header.timestamp = getTimestamp();
+		header.dataSize = 0;
+		header.itemsCount = 0;
+		if (dos2_fwrite((char*)&header, sizeof(ListCacheHeader_t), fh) != sizeof(ListCacheHeader_t)) goto end;
+	} else {
+		// Next pages: only if the file holds the previous ones
+		fh = dos2_fopen(cacheFile, O_RDWR);
+		if (fh >= ERR_FIRST) return;
+		if (dos2_fread((char*)&header, sizeof(ListCacheHeader_t), fh) != sizeof(ListCacheHeader_t) ||
+			memcmp(header.key, cacheKey, LISTCACHE_KEY_SIZE) ||
+			header.itemsCount != pageStart) goto end;
+	}
+
+	// Append the page after the valid data
+	dos2_fseek(fh, sizeof(ListCacheHeader_t) + header.dataSize, SEEK_SET);
+	block.count = total - pageStart;
+	block.namesSize = vramAddress - pageVramAddress;
+	if (dos2_fwrite((char*)&block, sizeof(ListCacheBlock_t), fh) != sizeof(ListCacheBlock_t)) goto end;
+
+	for (index = pageStart; index < total; index += size) {
+		size = total - index;
+		if (size > CHUNK_ITEMS) size = CHUNK_ITEMS;
+		for (i = 0; i < size; i++) {
+			memcpy(buff + i * sizeof(ListItem_t), listStoreGet(index + i), sizeof(ListItem_t));
+		}
+		if (dos2_fwrite(buff, size * sizeof(ListItem_t), fh) != size * sizeof(ListItem_t)) goto end;
+	}
+
+	for (vram = pageVramAddress; vram < vramAddress; vram += size) {
+		size = vramAddress - vram > BUFF_SIZE ? BUFF_SIZE : vramAddress - vram;
+		msx2_copyFromVRAM(vram, (uint16_t)buff, size);
+		if (dos2_fwrite(buff, size, fh) != size) goto end;
+	}
+
+	// Commit the page updating the header
+	header.dataSize += sizeof(ListCacheBlock_t) + (uint32_t)block.count * sizeof(ListItem_t) + block.namesSize;
+	header.itemsCount = total;
+	header.complete = listComplete;
+	dos2_fseek(fh, 0, SEEK_SET);
+	dos2_fwrite((char*)&header, sizeof(ListCacheHeader_t), fh);
+
+end:
+	dos2_fclose(fh);
+}
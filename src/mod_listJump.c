@@ -0,0 +1,124 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "utils.h"
+#include "mod_listView.h"
+#include "mod_listJump.h"
+
+
+// ========================================================
+static uint16_t buckets[LISTJUMP_BUCKETS];	// Lowest list store index for each character
+static uint16_t nextItem;					// Item owning the next name
+static bool atNameStart;
+
+
+// ========================================================
+#define UPPER(c)	((c) >= 'a' && (c) <= 'z' ? (c) - 32 : (c))
+
+static uint8_t bucketOf(char c)
+{
+	if (c >= 'a' && c <= 'z') return c - 'a';
+	if (c >= 'A' && c <= 'Z') return c - 'A';
+	if (c >= '0' && c <= '9') return c - '0' + 26;
+	return LISTJUMP_BUCKETS;
+}
+
+
+// ========================================================
+// Forgets the items from count onwards
+void listJumpTruncate(uint16_t count)
+{
+	for (uint8_t i = 0; i < LISTJUMP_BUCKETS; i++) {
+		if (buckets[i] >= count) buckets[i] = LISTJUMP_NONE;
+	}
+	nextItem = count;
+	atNameStart = true;
+}
+
+// Names arrive in the same order as its items, each one ended by a '\0'
+void listJumpScan(char *names, uint16_t size)
+{
+	char *end = names + size;
+	uint8_t bucket;
+
+	while (names < end) {
+		if (atNameStart) {
+			bucket = bucketOf(*names);
+			if (bucket < LISTJUMP_BUCKETS && buckets[bucket] == LISTJUMP_NONE) {
+				buckets[bucket] = nextItem;
+			}
+			nextItem++;
+		}
+		names = memchr(names, '\0', end - names);
+		if (!names) {
+			atNameStart = false;
+			return;
+		}
+		names++;
+		atNameStart = true;
+	}
+}
+
+static char firstChar(uint16_t row)
+{
+	char c;
+
+	msx2_copyFromVRAM(listViewGet(row)->name, (uint16_t)&c, 1);
+	return UPPER(c);
+}
+
+// Row of the current view for the first name starting with the character
+uint16_t listJumpRow(char c)
+{
+	uint8_t bucket = bucketOf(c);
+	uint16_t index, low, high, mid;
+	bool before;
+
+	if (bucket >= LISTJUMP_BUCKETS) return LISTJUMP_NONE;
+	index = buckets[bucket];
+	if (index == LISTJUMP_NONE || !listViewActive) return index;
+
+	// Sorted by size: look for the item itself
+	if (listViewSort >= LISTVIEW_SORT_SIZE_ASC) {
+		for (low = 0; low < listViewCount; low++) {
+			if (listViewIndex(low) == index) return low;
+		}
+		return LISTJUMP_NONE;
+	}
+
+	// Sorted by name, or filtered keeping the list order: first row at or after it
+	c = UPPER(c);
+	low = 0;
+	high = listViewCount;
+	while (low < high) {
+		mid = (low + high) / 2;
+		switch (listViewSort) {
+			case LISTVIEW_SORT_NAME_ASC:
+				before = firstChar(mid) < c; break;
+			case LISTVIEW_SORT_NAME_DESC:
+				before = firstChar(mid) > c; break;
+			default:
+				before = listViewIndex(mid) < index;
+		}
+		if (before)
+			low = mid + 1;
+		else
+			high = mid;
+	}
+	if (listViewSort) {
+		if (low >= listViewCount || firstChar(low) != c) return LISTJUMP_NONE;
+		return low;
+	}
+
+	// Filtered only: the bucket item can be hidden, the first visible one follows it
+	for (; low < listViewCount; low++) {
+		if (firstChar(low) == c) return low;
+	}
+	return LISTJUMP_NONE;
+}
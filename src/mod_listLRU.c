@@ -0,0 +1,256 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dos.h"
+#include "utils.h"
+#include "fh.h"
+#include "mod_listStore.h"
+#include "mod_listJump.h"
+#include "mod_listLRU.h"
+
+
+// ========================================================
+static MAPPER_Segment pool[LISTLRU_MAX_SEGMENTS];
+static uint8_t poolOwner[LISTLRU_MAX_SEGMENTS];		// Entry using each segment
+static uint8_t poolAllocated;
+
+static ListLRUEntry_t entries[LISTLRU_ENTRIES];
+static ListLRUEntry_t selected;						// Key of the current list
+static bool selectedStored;							// Current list equal to its entry
+
+// Items are copied through here (must be outside page 2)
+static ListItem_t bounce[LISTLRU_BOUNCE_ITEMS];
+
+
+// ========================================================
+static ListLRUEntry_t* findEntry()
+{
+	ListLRUEntry_t *entry = entries;
+
+	for (uint8_t i = 0; i < LISTLRU_ENTRIES; i++, entry++) {
+		if (entry->age != LISTLRU_EMPTY &&
+			entry->type == selected.type &&
+			entry->msx == selected.msx &&
+			!strcmp(entry->search, selected.search)) return entry;
+	}
+	return NULL;
+}
+
+static ListLRUEntry_t* oldestEntry(ListLRUEntry_t *except)
+{
+	ListLRUEntry_t *entry = entries, *oldest = NULL;
+
+	for (uint8_t i = 0; i < LISTLRU_ENTRIES; i++, entry++) {
+		if (entry != except && entry->age != LISTLRU_EMPTY &&
+			(!oldest || entry->age > oldest->age)) oldest = entry;
+	}
+	return oldest;
+}
+
+// Makes the entry the most recent one; only the entries younger than its previous age get older
+static void touchEntry(ListLRUEntry_t *entry, uint8_t oldAge)
+{
+	ListLRUEntry_t *other = entries;
+
+	if (oldAge > LISTLRU_ENTRIES-1) oldAge = LISTLRU_ENTRIES-1;
+	for (uint8_t i = 0; i < LISTLRU_ENTRIES; i++, other++) {
+		if (other != entry && other->age < oldAge) other->age++;
+	}
+	entry->age = 0;
+}
+
+static void freeEntry(ListLRUEntry_t *entry)
+{
+	while (entry->segCount) {
+		poolOwner[entry->segs[--entry->segCount]] = LISTLRU_EMPTY;
+	}
+	entry->age = LISTLRU_EMPTY;
+}
+
+static bool assignSegments(ListLRUEntry_t *entry, uint8_t count)
+{
+	ListLRUEntry_t *victim;
+	uint8_t i;
+
+	while (entry->segCount < count) {
+		for (i = 0; i < poolAllocated && poolOwner[i] != LISTLRU_EMPTY; i++);
+		if (i == poolAllocated) {
+			if (poolAllocated < LISTLRU_MAX_SEGMENTS && !mapperAllocateSegment(&pool[poolAllocated])) {
+				poolAllocated++;
+			} else {
+				// Make room dropping the oldest list
+				victim = oldestEntry(entry);
+				if (!victim) return false;
+				freeEntry(victim);
+				continue;
+			}
+		}
+		poolOwner[i] = entry - entries;
+		entry->segs[entry->segCount++] = i;
+	}
+	return true;
+}
+
+// Pages in the segment holding the stream offset; returns its address in page 2
+static uint8_t* mapStream(ListLRUEntry_t *entry, uint32_t offset, uint16_t *avail)
+{
+	uint16_t pos = offset % LISTSTORE_SEGMENT_SIZE;
+
+	*avail = LISTSTORE_SEGMENT_SIZE - pos;
+	mapperSetSegment(LISTSTORE_PAGE, &pool[entry->segs[offset / LISTSTORE_SEGMENT_SIZE]]);
+	return (uint8_t*)LISTSTORE_WINDOW + pos;
+}
+
+static void streamRAM(ListLRUEntry_t *entry, uint32_t offset, uint8_t *ram, uint16_t size, bool write)
+{
+	uint16_t avail;
+	uint8_t *ptr;
+
+	while (size) {
+		ptr = mapStream(entry, offset, &avail);
+		if (avail > size) avail = size;
+		if (write)
+			memcpy(ptr, ram, avail);
+		else
+			memcpy(ram, ptr, avail);
+		mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+		offset += avail;
+		ram += avail;
+		size -= avail;
+	}
+}
+
+static void streamVRAM(ListLRUEntry_t *entry, uint32_t offset, uint32_t vram, uint32_t size, bool write)
+{
+	uint16_t avail;
+	uint8_t *ptr;
+
+	while (size) {
+		ptr = mapStream(entry, offset, &avail);
+		if (avail > size) avail = size;
+		if (write) {
+			msx2_copyFromVRAM(vram, (uint16_t)ptr, avail);
+		} else {
+			listJumpScan((char*)ptr, avail);
+			msx2_copyToVRAM((uint16_t)ptr, vram, avail);
+		}
+		mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+		offset += avail;
+		vram += avail;
+		size -= avail;
+	}
+}
+
+
+// ========================================================
+void listLRUInit()
+{
+	for (uint8_t i = 0; i < LISTLRU_ENTRIES; i++) {
+		entries[i].age = LISTLRU_EMPTY;
+		entries[i].segCount = 0;
+	}
+	poolAllocated = 0;
+	selected.type = NULL;
+}
+
+void listLRURelease()
+{
+	while (poolAllocated) {
+		mapperFreeSegment(&pool[--poolAllocated]);
+	}
+}
+
+// Keeps the current list before it is replaced
+void listLRUStore()
+{
+	ListLRUEntry_t *entry;
+	uint32_t itemsSize, namesSize;
+	uint16_t total = listStoreCount();
+	uint16_t index, count, i;
+	uint8_t oldAge;
+
+	// A list with missing pages would be taken as the whole one
+	if (!selected.type || !total || listCutShort) return;
+
+	entry = findEntry();
+	if (entry && selectedStored && entry->itemsCount == total) {
+		touchEntry(entry, entry->age);
+		return;
+	}
+	if (!entry) {
+		for (entry = entries; entry < entries + LISTLRU_ENTRIES && entry->age != LISTLRU_EMPTY; entry++);
+		if (entry == entries + LISTLRU_ENTRIES) {
+			entry = oldestEntry(NULL);
+		}
+	}
+	oldAge = entry->age;
+	freeEntry(entry);
+
+	itemsSize = (uint32_t)total * sizeof(ListItem_t);
+	namesSize = vramAddress - VRAM_START;
+	count = (itemsSize + namesSize + LISTSTORE_SEGMENT_SIZE - 1) / LISTSTORE_SEGMENT_SIZE;
+	if (count > LISTLRU_MAX_SEGMENTS || !assignSegments(entry, count)) {
+		freeEntry(entry);
+		return;
+	}
+
+	for (index = 0; index < total; index += count) {
+		count = total - index;
+		if (count > LISTLRU_BOUNCE_ITEMS) count = LISTLRU_BOUNCE_ITEMS;
+		for (i = 0; i < count; i++) {
+			memcpy(&bounce[i], listStoreGet(index + i), sizeof(ListItem_t));
+		}
+		streamRAM(entry, (uint32_t)index * sizeof(ListItem_t), (uint8_t*)bounce, count * sizeof(ListItem_t), true);
+	}
+	streamVRAM(entry, itemsSize, VRAM_START, namesSize, true);
+
+	entry->type = selected.type;
+	entry->msx = selected.msx;
+	strcpy(entry->search, selected.search);
+	entry->itemsCount = total;
+	entry->namesSize = namesSize;
+	entry->complete = listComplete;
+	touchEntry(entry, oldAge);
+	selectedStored = true;
+}
+
+// Sets the key of the list about to be loaded
+void listLRUSelect()
+{
+	selected.type = request.type;
+	selected.msx = request.msx;
+	strcpy(selected.search, request.search.value);
+	selectedStored = false;
+}
+
+bool listLRULoad()
+{
+	ListLRUEntry_t *entry = findEntry();
+	uint16_t index, count;
+
+	if (!entry) return false;
+
+	for (index = 0; index < entry->itemsCount; index += count) {
+		count = entry->itemsCount - index;
+		if (count > LISTLRU_BOUNCE_ITEMS) count = LISTLRU_BOUNCE_ITEMS;
+		streamRAM(entry, (uint32_t)index * sizeof(ListItem_t), (uint8_t*)bounce, count * sizeof(ListItem_t), false);
+		if (!listStoreAppend(bounce, count)) {
+			listStoreTruncate(0);
+			listJumpTruncate(0);
+			return false;
+		}
+	}
+	streamVRAM(entry, (uint32_t)entry->itemsCount * sizeof(ListItem_t), VRAM_START, entry->namesSize, false);
+
+	vramAddress = VRAM_START + entry->namesSize;
+	listComplete = entry->complete;
+	touchEntry(entry, entry->age);
+	selectedStored = true;
+	return true;
+}
@@ -0,0 +1,143 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dos.h"
+#include "structs.h"
+#include "mod_listStore.h"
+
+
+// ========================================================
+static MAPPER_Segment segments[LISTSTORE_MAX_SEGMENTS];
+static uint8_t segmentsAllocated;
+
+static ListItem_t *tpaStart;
+static uint16_t tpaCapacity;
+static uint16_t itemsStored;
+
+// Copy of the last item read from a segment (must be outside page 2)
+static ListItem_t itemCache;
+
+// Bounce buffer for items appended from page 2
+static ListItem_t stage[LISTSTORE_STAGE_ITEMS];
+
+
+// ========================================================
+void listStoreInit()
+{
+	mapperInit();
+	segmentsAllocated = 0;
+}
+
+void listStoreRelease()
+{
+	while (segmentsAllocated) {
+		mapperFreeSegment(&segments[--segmentsAllocated]);
+	}
+}
+
+void listStoreReset(ListItem_t *start, uint16_t capacity)
+{
+	tpaStart = start;
+	tpaCapacity = capacity;
+	itemsStored = 0;
+}
+
+bool listStoreAppend(ListItem_t *items, uint16_t count)
+{
+	ListItem_t *src;
+	uint16_t size, index;
+	uint8_t segment;
+
+	if (itemsStored + count > LISTSTORE_MAX_ITEMS) return false;
+
+	// Fill the TPA area first
+	if (itemsStored < tpaCapacity) {
+		size = tpaCapacity - itemsStored;
+		if (size > count) size = count;
+		if (items != tpaStart + itemsStored) {		// Not received in place
+			memcpy(tpaStart + itemsStored, items, size * sizeof(ListItem_t));
+		}
+		itemsStored += size;
+		items += size;
+		count -= size;
+	}
+
+	// Spill the rest into mapper segments (items never cross a segment boundary)
+	while (count) {
+		index = itemsStored - tpaCapacity;
+		segment = index / LISTSTORE_SEGMENT_ITEMS;
+		index %= LISTSTORE_SEGMENT_ITEMS;
+
+		if (segment >= segmentsAllocated) {
+			if (segment >= LISTSTORE_MAX_SEGMENTS || mapperAllocateSegment(&segments[segment])) {
+				return false;
+			}
+			segmentsAllocated++;
+		}
+
+		size = LISTSTORE_SEGMENT_ITEMS - index;
+		if (size > count) size = count;
+
+		// A source in page 2 would be hidden by the segment: copy it through the stage
+		src = items;
+		if ((uint16_t)items < 0xc000 && (uint16_t)(items + size) > (uint16_t)LISTSTORE_WINDOW) {
+			if (size > LISTSTORE_STAGE_ITEMS) size = LISTSTORE_STAGE_ITEMS;
+			memcpy(stage, items, size * sizeof(ListItem_t));
+			src = stage;
+		}
+
+		mapperSetSegment(LISTSTORE_PAGE, &segments[segment]);
+		memcpy(LISTSTORE_WINDOW + index, src, size * sizeof(ListItem_t));
+		mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+
+		itemsStored += size;
+		items += size;
+		count -= size;
+	}
+	return true;
+}
+
+void listStoreTruncate(uint16_t count)
+{
+	if (count < itemsStored) {
+		itemsStored = count;
+	}
+}
+
+ListItem_t* listStoreGet(uint16_t index)
+{
+	if (index < tpaCapacity) {
+		return tpaStart + index;
+	}
+	index -= tpaCapacity;
+
+	mapperSetSegment(LISTSTORE_PAGE, &segments[index / LISTSTORE_SEGMENT_ITEMS]);
+	memcpy(&itemCache, LISTSTORE_WINDOW + (index % LISTSTORE_SEGMENT_ITEMS), sizeof(ListItem_t));
+	mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+
+	return &itemCache;
+}
+
+uint16_t listStoreCount()
+{
+	return itemsStored;
+}
+
+void* listStoreTpaEnd()
+{
+	return tpaStart + (itemsStored < tpaCapacity ? itemsStored : tpaCapacity);
+}
+
+// Where the next items go while the TPA area has room, so they can be written in place
+ListItem_t* listStoreTpaFree(uint16_t *count)
+{
+	if (itemsStored >= tpaCapacity) return NULL;
+	*count = tpaCapacity - itemsStored;
+	return tpaStart + itemsStored;
+}
@@ -0,0 +1,426 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "dos.h"
+#include "utils.h"
+#include "fh.h"
+#include "mod_listStore.h"
+#include "mod_listView.h"
+
+
+// ========================================================
+#define UPPER(c)	((c) >= 'a' && (c) <= 'z' ? (c) - 32 : (c))
+
+static MAPPER_Segment segments[LISTVIEW_MAX_SEGMENTS];
+static uint8_t segmentsAllocated;
+
+bool listViewActive;
+uint16_t listViewCount;
+char listViewFilter[SEARCH_MAX_SIZE + 1];
+uint8_t listViewSort;
+static char pattern[SEARCH_MAX_SIZE + 1];		// Uppercase filter
+static uint32_t blockStart, blockEnd;			// Names block in buff
+
+static MAPPER_Segment sortSegments[LISTVIEW_SORT_SEGMENTS];
+static uint8_t sortSegmentsAllocated;
+static SortRecord_t heads[LISTVIEW_SORT_SEGMENTS > LISTVIEW_SORT_BATCH ? LISTVIEW_SORT_SEGMENTS : LISTVIEW_SORT_BATCH];
+static SortRecord_t last, swap;
+static char keyChars[LISTVIEW_SORT_KEY];
+
+// Matches waiting to be written to the index (must be outside page 2)
+static uint16_t batch[LISTVIEW_BATCH];
+
+
+// ========================================================
+static uint16_t readIndex(uint16_t row)
+{
+	uint16_t value;
+
+	mapperSetSegment(LISTSTORE_PAGE, &segments[row / LISTVIEW_SEGMENT_ENTRIES]);
+	value = ((uint16_t*)LISTSTORE_WINDOW)[row % LISTVIEW_SEGMENT_ENTRIES];
+	mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+	return value;
+}
+
+static void writeIndexes(uint16_t row, uint16_t *values, uint16_t count)
+{
+	uint16_t pos, size;
+
+	while (count) {
+		pos = row % LISTVIEW_SEGMENT_ENTRIES;
+		size = LISTVIEW_SEGMENT_ENTRIES - pos;
+		if (size > count) size = count;
+
+		mapperSetSegment(LISTSTORE_PAGE, &segments[row / LISTVIEW_SEGMENT_ENTRIES]);
+		memcpy((uint16_t*)LISTSTORE_WINDOW + pos, values, size * sizeof(uint16_t));
+		mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+
+		row += size;
+		values += size;
+		count -= size;
+	}
+}
+
+static bool allocateIndex(uint16_t entries)
+{
+	uint8_t needed = (entries + LISTVIEW_SEGMENT_ENTRIES - 1) / LISTVIEW_SEGMENT_ENTRIES;
+
+	while (segmentsAllocated < needed) {
+		if (mapperAllocateSegment(&segments[segmentsAllocated])) return false;
+		segmentsAllocated++;
+	}
+	return true;
+}
+
+// Case insensitive search of the pattern in a name
+static bool matchName(char *name, char *end)
+{
+	char *s, *p;
+
+	for (; name < end && *name; name++) {
+		for (s = name, p = pattern; *p && s < end && UPPER(*s) == *p; s++, p++);
+		if (!*p) return true;
+	}
+	return false;
+}
+
+
+// The names are read from VRAM in BUFF_SIZE blocks: they are stored
+// consecutively, so a block usually holds several of them.
+static char* readName(uint32_t name, char **end)
+{
+	uint16_t size;
+
+	if (name < blockStart || (name + LISTVIEW_NAME_MAX > blockEnd && blockEnd < vramAddress)) {
+		size = vramAddress - name > BUFF_SIZE ? BUFF_SIZE : vramAddress - name;
+		msx2_copyFromVRAM(name, (uint16_t)buff, size);
+		blockStart = name;
+		blockEnd = name + size;
+	}
+	*end = buff + (uint16_t)(blockEnd - blockStart);
+	return buff + (uint16_t)(name - blockStart);
+}
+
+// ========================================================
+// Sort: the rows are turned into SortRecord_t with a key that keeps the
+// wanted order (8 uppercase chars or the size, negated when descending).
+// Every sort segment is sorted in place while paged in, and the segments
+// are merged into the view index. Rows whose names tie in those chars are
+// marked, and every run of them is sorted again by the next 8 chars.
+
+#define SORT_LESS(a, b)	((a)->hi < (b)->hi || ((a)->hi == (b)->hi && \
+						((a)->lo < (b)->lo || ((a)->lo == (b)->lo && (a)->index < (b)->index))))
+#define SORT_SAME(a, b)	((a)->hi == (b)->hi && (a)->lo == (b)->lo)
+
+static SortRecord_t* mapRecord(uint16_t record)
+{
+	mapperSetSegment(LISTSTORE_PAGE, &sortSegments[record / LISTVIEW_SORT_RECORDS]);
+	return (SortRecord_t*)LISTSTORE_WINDOW + (record % LISTVIEW_SORT_RECORDS);
+}
+
+static void readRecord(uint16_t record, SortRecord_t *dest)
+{
+	memcpy(dest, mapRecord(record), sizeof(SortRecord_t));
+	mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+}
+
+static void writeRecords(uint16_t record, SortRecord_t *src, uint16_t count)
+{
+	while (count--) {
+		memcpy(mapRecord(record++), src++, sizeof(SortRecord_t));
+		mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+	}
+}
+
+static bool allocateSort(uint8_t needed)
+{
+	while (sortSegmentsAllocated < needed) {
+		if (mapperAllocateSegment(&sortSegments[sortSegmentsAllocated])) return false;
+		sortSegmentsAllocated++;
+	}
+	return true;
+}
+
+// Key of the size, or of the name chars from depth onwards
+static void makeKey(SortRecord_t *record, uint16_t index, uint8_t depth)
+{
+	ListItem_t *item = listStoreGet(index);
+	uint8_t *hi = (uint8_t*)&record->hi, *lo = (uint8_t*)&record->lo;
+	char *name, *end;
+	uint8_t i;
+
+	record->index = index;
+	if (listViewSort >= LISTVIEW_SORT_SIZE_ASC) {
+		record->hi = item->size;
+		record->lo = 0;
+	} else {
+		// Big-endian packing: hi holds chars 0-3, lo holds chars 4-7
+		record->hi = record->lo = 0;
+		if (depth) {
+			// The tied names are spread over VRAM: read just the chars needed
+			msx2_copyFromVRAM(item->name + depth, (uint16_t)keyChars, LISTVIEW_SORT_KEY);
+			name = keyChars;
+			end = keyChars + LISTVIEW_SORT_KEY;
+		} else {
+			name = readName(item->name, &end);
+		}
+		for (i = 0; i < LISTVIEW_SORT_KEY && name < end && *name; i++, name++) {
+			if (i < 4)
+				hi[3 - i] = UPPER(*name);
+			else
+				lo[7 - i] = UPPER(*name);
+		}
+	}
+	if (listViewSort == LISTVIEW_SORT_NAME_DESC || listViewSort == LISTVIEW_SORT_SIZE_DESC) {
+		record->hi = ~record->hi;
+		record->lo = ~record->lo;
+	}
+}
+
+// Iterative quicksort (inclusive bounds), insertion sort for small ranges
+static void sortRecords(SortRecord_t *lo, SortRecord_t *hi)
+{
+	SortRecord_t *stack[2 * 16];
+	SortRecord_t pivot, *i, *j;
+	uint8_t sp = 0;
+
+	for (;;) {
+		if (hi - lo < 8) {
+			for (i = lo + 1; i <= hi; i++) {
+				memcpy(&pivot, i, sizeof(SortRecord_t));
+				for (j = i; j > lo && SORT_LESS(&pivot, j - 1); j--) {
+					memcpy(j, j - 1, sizeof(SortRecord_t));
+				}
+				memcpy(j, &pivot, sizeof(SortRecord_t));
+			}
+			if (!sp) return;
+			hi = stack[--sp];
+			lo = stack[--sp];
+			continue;
+		}
+
+		memcpy(&pivot, lo + (hi - lo) / 2, sizeof(SortRecord_t));
+		i = lo - 1;
+		j = hi + 1;
+		for (;;) {
+			do { i++; } while (SORT_LESS(i, &pivot));
+			do { j--; } while (SORT_LESS(&pivot, j));
+			if (i >= j) break;
+			memcpy(&swap, i, sizeof(SortRecord_t));
+			memcpy(i, j, sizeof(SortRecord_t));
+			memcpy(j, &swap, sizeof(SortRecord_t));
+		}
+
+		// Continue with the smaller part
+		if (j - lo < hi - j) {
+			stack[sp++] = j + 1;
+			stack[sp++] = hi;
+			hi = j;
+		} else {
+			stack[sp++] = lo;
+			stack[sp++] = j;
+			lo = j + 1;
+		}
+	}
+}
+
+// Sorts the view rows [start, end) by the key at depth. A row whose key ties
+// with the previous one while the names go on gets LISTVIEW_SORT_TIE.
+static bool sortRange(uint16_t start, uint16_t end, uint8_t depth)
+{
+	uint16_t total = end - start;
+	uint16_t pos[LISTVIEW_SORT_SEGMENTS], limit[LISTVIEW_SORT_SEGMENTS];
+	uint16_t row, index, pending = 0;
+	uint8_t chunks = (total + LISTVIEW_SORT_RECORDS - 1) / LISTVIEW_SORT_RECORDS;
+	uint8_t c, best;
+	uint8_t nameEnd = listViewSort == LISTVIEW_SORT_NAME_DESC ? 0xff : 0;
+	bool byName = listViewSort < LISTVIEW_SORT_SIZE_ASC, ties = false;
+
+	// Gather the keys of the rows
+	blockStart = blockEnd = 0;
+	for (row = 0; row < total; row += pending) {
+		pending = total - row;
+		if (pending > LISTVIEW_SORT_BATCH) pending = LISTVIEW_SORT_BATCH;
+		for (c = 0; c < pending; c++) {
+			index = depth ? readIndex(start + row + c) & ~LISTVIEW_SORT_TIE : listViewIndex(row + c);
+			makeKey(&heads[c], index, depth);
+		}
+		writeRecords(row, heads, pending);
+	}
+
+	// Sort every segment
+	for (c = 0; c < chunks; c++) {
+		pos[c] = c * LISTVIEW_SORT_RECORDS;
+		limit[c] = c == chunks - 1 ? total : pos[c] + LISTVIEW_SORT_RECORDS;
+		sortRecords(mapRecord(pos[c]), mapRecord(limit[c] - 1));
+		mapperSetOriginalSegmentBack(LISTSTORE_PAGE);
+		readRecord(pos[c], &heads[c]);
+	}
+
+	// Merge them into the view
+	pending = 0;
+	for (row = 0; row < total; row++) {
+		best = 0xff;
+		for (c = 0; c < chunks; c++) {
+			if (pos[c] < limit[c] && (best == 0xff || SORT_LESS(&heads[c], &heads[best]))) best = c;
+		}
+
+		index = heads[best].index;
+		if (byName && row && SORT_SAME(&heads[best], &last) && (uint8_t)last.lo != nameEnd) {
+			index |= LISTVIEW_SORT_TIE;
+			ties = true;
+		}
+		memcpy(&last, &heads[best], sizeof(SortRecord_t));
+
+		batch[pending++] = index;
+		if (pending == LISTVIEW_BATCH) {
+			writeIndexes(start + row + 1 - pending, batch, pending);
+			pending = 0;
+		}
+		if (++pos[best] < limit[best]) readRecord(pos[best], &heads[best]);
+	}
+	writeIndexes(start + total - pending, batch, pending);
+	return ties;
+}
+
+static bool sortRows()
+{
+	uint16_t total = listViewActive ? listViewCount : listStoreCount();
+	uint16_t row, next, value;
+	uint8_t chunks = (total + LISTVIEW_SORT_RECORDS - 1) / LISTVIEW_SORT_RECORDS;
+	uint8_t depth;
+	bool ties;
+
+	if (chunks > LISTVIEW_SORT_SEGMENTS || !allocateSort(chunks) || !allocateIndex(total)) return false;
+
+	// Every pass sorts the runs of tied rows again by the next chars of their names
+	ties = sortRange(0, total, 0);
+	for (depth = LISTVIEW_SORT_KEY; ties && depth < LISTVIEW_NAME_MAX; depth += LISTVIEW_SORT_KEY) {
+		ties = false;
+		for (row = 0; row < total; row = next) {
+			for (next = row + 1; next < total && (readIndex(next) & LISTVIEW_SORT_TIE); next++);
+			if (next - row > 1 && sortRange(row, next, depth)) ties = true;
+		}
+	}
+
+	// Names still equal after LISTVIEW_NAME_MAX chars keep the list order
+	for (row = 0; ties && row < total; row++) {
+		value = readIndex(row);
+		if (value & LISTVIEW_SORT_TIE) {
+			value &= ~LISTVIEW_SORT_TIE;
+			writeIndexes(row, &value, 1);
+		}
+	}
+
+	listViewCount = total;
+	listViewActive = true;
+	return true;
+}
+
+
+// ========================================================
+void listViewInit()
+{
+	segmentsAllocated = sortSegmentsAllocated = 0;
+	listViewReset();
+}
+
+void listViewRelease()
+{
+	while (segmentsAllocated) {
+		mapperFreeSegment(&segments[--segmentsAllocated]);
+	}
+	while (sortSegmentsAllocated) {
+		mapperFreeSegment(&sortSegments[--sortSegmentsAllocated]);
+	}
+}
+
+void listViewReset()
+{
+	listViewActive = false;
+	listViewFilter[0] = pattern[0] = '\0';
+	listViewSort = LISTVIEW_SORT_NONE;
+}
+
+// Looks for the text in the names of the list, or of the current rows when narrowing
+static bool filterRows(bool narrow)
+{
+	uint16_t total, row, index, matches = 0, pending = 0;
+	char *name, *end;
+
+	total = narrow ? listViewCount : listStoreCount();
+	if (!allocateIndex(total)) return false;
+
+	blockStart = blockEnd = 0;
+	for (row = 0; row < total; row++) {
+		index = narrow ? readIndex(row) : row;
+		name = readName(listStoreGet(index)->name, &end);
+
+		if (matchName(name, end)) {
+			batch[pending++] = index;
+			if (pending == LISTVIEW_BATCH) {
+				writeIndexes(matches, batch, pending);
+				matches += pending;
+				pending = 0;
+			}
+		}
+	}
+	writeIndexes(matches, batch, pending);
+
+	listViewCount = matches + pending;
+	listViewActive = true;
+	return true;
+}
+
+static bool rebuildView()
+{
+	listViewActive = false;
+	if ((*pattern && !filterRows(false)) || (listViewSort && !sortRows())) {
+		listViewReset();
+		return false;
+	}
+	return true;
+}
+
+// Keeps the items whose name contains the text
+bool listViewSetFilter(char *text)
+{
+	bool narrow;
+	char *ptr;
+
+	// A longer filter only needs to look at the rows already shown
+	narrow = listViewActive && !strncmp(text, listViewFilter, strlen(listViewFilter));
+
+	strcpy(listViewFilter, text);
+	for (ptr = pattern; *text; text++) {
+		*ptr++ = UPPER(*text);
+	}
+	*ptr = '\0';
+
+	if (narrow && *pattern) {
+		return filterRows(true);
+	}
+	return rebuildView();
+}
+
+bool listViewSetSort(uint8_t mode)
+{
+	listViewSort = mode;
+	return rebuildView();
+}
+
+uint16_t listViewIndex(uint16_t row)
+{
+	return listViewActive ? readIndex(row) : row;
+}
+
+ListItem_t* listViewGet(uint16_t row)
+{
+	return listStoreGet(listViewIndex(row));
+}
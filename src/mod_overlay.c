@@ -0,0 +1,38 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include "conio_aux.h"
+#include "mod_pageFlip.h"
+#include "mod_panelScroll.h"
+#include "mod_overlay.h"
+
+
+// ========================================================
+static uint16_t savedNames, savedBlink;
+static uint16_t namesSize, blinkSize;
+
+
+// ========================================================
+void overlaySave(uint8_t y, uint8_t height)
+{
+	savedNames = (y-1)*80;
+	namesSize = height*80;
+	savedBlink = (y-1)*10;
+	blinkSize = height*10;
+
+	// The back table no longer holds a prepared page
+	pageFlipInvalidate();
+
+	panelScrollCopy(savedNames, OVERLAY_NAMES_SAVE + savedNames, namesSize);
+	panelScrollCopy(ADR_BLINK + savedBlink, OVERLAY_BLINK_SAVE + savedBlink, blinkSize);
+}
+
+void overlayRestore()
+{
+	panelScrollCopy(OVERLAY_NAMES_SAVE + savedNames, savedNames, namesSize);
+	panelScrollCopy(OVERLAY_BLINK_SAVE + savedBlink, ADR_BLINK + savedBlink, blinkSize);
+}
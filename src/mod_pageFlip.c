@@ -0,0 +1,149 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "conio_aux.h"
+#include "utils.h"
+#include "fh.h"
+#include "mod_listView.h"
+#include "mod_panelShadow.h"
+#include "mod_panelScroll.h"
+#include "mod_pageFlip.h"
+
+
+// ========================================================
+uint16_t pageFlipTable = PAGEFLIP_HOME_TABLE;	// Name table being shown
+static int16_t backTop = PAGEFLIP_NONE;		// First row drawn in the hidden table
+static int16_t backCount;					// itemsCount when it was drawn
+static uint8_t backRows;					// Rows already drawn
+static bool backFrame;						// Header and footer rows copied to the hidden table
+
+
+// ========================================================
+static bool isBackValid(int16_t top)
+{
+	return backTop == top && backCount == itemsCount;
+}
+
+static void drawBackRow()
+{
+	uint16_t line = PAGEFLIP_HIDDEN_TABLE + (PANEL_FIRSTY-1 + backRows)*80;
+	int16_t row = backTop + backRows++;
+	uint8_t nameLen;
+
+	_fillVRAM(line, 80, ' ');
+	if (row < itemsCount && formatItem(listViewIndex(row), 0, &nameLen)) {
+		msx2_copyToVRAM((uint16_t)buff, line + PANELSHADOW_POSX-1, PANELSHADOW_WIDTH);
+	}
+}
+
+static void startBack(int16_t top)
+{
+	backTop = top;
+	backCount = itemsCount;
+	backRows = 0;
+}
+
+// From then on the header and footer are written to both tables
+static void copyFrame()
+{
+	panelScrollCopy(pageFlipTable, PAGEFLIP_HIDDEN_TABLE, PAGEFLIP_HEADER_SIZE);
+	panelScrollCopy(pageFlipTable + PAGEFLIP_FOOTER_POS, PAGEFLIP_HIDDEN_TABLE + PAGEFLIP_FOOTER_POS, PAGEFLIP_FOOTER_SIZE);
+	backFrame = true;
+}
+
+static void showTable(uint16_t table)
+{
+	ASM_EI; ASM_HALT;
+	vdp_setRegister(2, PAGEFLIP_REG2(table));
+	pageFlipTable = table;
+}
+
+
+// ========================================================
+void pageFlipInvalidate()
+{
+	backTop = PAGEFLIP_NONE;
+}
+
+// Copies the frame, or draws one more row of the page starting at top
+void pageFlipIdle(int16_t top)
+{
+	if (top < 0 || top >= itemsCount) return;
+
+	if (!backFrame) {
+		copyFrame();
+		return;
+	}
+	if (!isBackValid(top)) {
+		startBack(top);
+	}
+	if (backRows < PANEL_HEIGHT) {
+		drawBackRow();
+	}
+}
+
+// Shows the page starting at top from the hidden table, drawing what is missing,
+// and leaves the other one hidden
+void pageFlipShow(int16_t top)
+{
+	if (!backFrame) {
+		copyFrame();
+	}
+	if (!isBackValid(top)) {
+		startBack(top);
+	}
+	while (backRows < PANEL_HEIGHT) {
+		drawBackRow();
+	}
+
+	showTable(PAGEFLIP_HIDDEN_TABLE);
+	backTop = PAGEFLIP_NONE;
+	panelShadowInvalidate();		// The shadow was for the other table
+}
+
+// Shows table 0 again, with the panel as it is now, before drawing with conio.
+// The hidden table can be overwritten afterwards (dialogs save area).
+void pageFlipHome()
+{
+	backTop = PAGEFLIP_NONE;
+	backFrame = false;
+	if (pageFlipTable == PAGEFLIP_HOME_TABLE) return;
+
+	panelScrollCopy(pageFlipTable + PAGEFLIP_HEADER_SIZE, PAGEFLIP_HOME_TABLE + PAGEFLIP_HEADER_SIZE, PANEL_HEIGHT*80);
+	showTable(PAGEFLIP_HOME_TABLE);
+}
+
+// Writes to the table shown, like putlinexy
+void pageFlipPutLine(uint8_t x, uint8_t y, uint16_t len, char *text)
+{
+	msx2_copyToVRAM((uint16_t)text, pageFlipTable + (y-1)*80 + x-1, len);
+}
+
+// Writes to the table shown; a header or footer text also to the hidden one
+void pageFlipPutStr(uint8_t x, uint8_t y, char *str)
+{
+	uint16_t pos = (y-1)*80 + x-1;
+	uint16_t len = strlen(str);
+
+	msx2_copyToVRAM((uint16_t)str, pageFlipTable + pos, len);
+	if (backFrame && (y < PANEL_FIRSTY || y > PANEL_LASTY)) {
+		msx2_copyToVRAM((uint16_t)str, PAGEFLIP_HIDDEN_TABLE + pos, len);
+	}
+}
+
+// Writes a header or footer char to both tables
+void pageFlipPutByte(uint16_t pos, uint8_t value)
+{
+	setByteVRAM(pageFlipTable + pos, value);
+	if (backFrame) {
+		setByteVRAM(PAGEFLIP_HIDDEN_TABLE + pos, value);
+	}
+}
@@ -0,0 +1,178 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "msx_const.h"
+#include "conio.h"
+#include "conio_aux.h"
+#include "utils.h"
+#include "fh.h"
+#include "mod_panelScroll.h"
+#include "mod_panelShadow.h"
+#include "mod_pageFlip.h"
+
+
+// ========================================================
+#define SCROLL_SIZE		((PANEL_HEIGHT-1)*80)
+#define FIRST_ROW		(pageFlipTable+(PANEL_FIRSTY-1)*80)
+#define SECOND_ROW		(pageFlipTable+(PANEL_FIRSTY)*80)
+
+bool panelScrollVDP;
+
+static VDP_Command_t cmd;
+static uint8_t originalRG25;
+
+// The CPU copy goes through here, a whole scroll at once: while a list
+// page is being received heap_top is just over the stack
+static uint8_t bounce[SCROLL_SIZE];
+
+
+// ========================================================
+// Linear VRAM move done by the command engine. With the CMD bit set the
+// name table is seen as 256 bytes per line, so it is split in pieces that
+// don't cross a line, copying backwards when the target is after the source.
+static void moveVDP(uint16_t src, uint16_t dst, uint16_t size)
+{
+	uint16_t len, max;
+
+	if (dst > src) {
+		src += size - 1;
+		dst += size - 1;
+		cmd.arg = VDP_ARG_DIX;
+	} else {
+		cmd.arg = 0;
+	}
+	cmd.ny = 1;
+	cmd.cmd = VDP_HMMM;
+
+	while (size) {
+		if (cmd.arg) {
+			len = (src & 0xff) + 1;
+			max = (dst & 0xff) + 1;
+		} else {
+			len = 0x100 - (src & 0xff);
+			max = 0x100 - (dst & 0xff);
+		}
+		if (max < len) len = max;
+		if (size < len) len = size;
+
+		cmd.sx = src & 0xff;
+		cmd.sy = src >> 8;
+		cmd.dx = dst & 0xff;
+		cmd.dy = dst >> 8;
+		cmd.nx = len;
+		vdp_runCommand(&cmd);
+
+		if (cmd.arg) {
+			src -= len;
+			dst -= len;
+		} else {
+			src += len;
+			dst += len;
+		}
+		size -= len;
+	}
+	// The CPU writes the new row next
+	vdp_waitCommand();
+}
+
+// Everything copied is below 16K: the 14 bits address copies are enough.
+// Longer copies are moved by pieces, backwards when the target is after the source.
+static void moveCPU(uint16_t src, uint16_t dst, uint16_t size)
+{
+	uint16_t len;
+	bool backwards = dst > src;
+
+	if (backwards) {
+		src += size;
+		dst += size;
+	}
+	while (size) {
+		len = size < sizeof(bounce) ? size : sizeof(bounce);
+		if (backwards) {
+			src -= len;
+			dst -= len;
+		}
+		_copyVRAMtoRAM(src, (uint16_t)bounce, len);
+		_copyRAMtoVRAM((uint16_t)bounce, dst, len);
+		if (!backwards) {
+			src += len;
+			dst += len;
+		}
+		size -= len;
+	}
+}
+
+// The BIOS keeps a mirror of R#25 that must follow the register
+static void setRG25(uint8_t value)
+{
+	varRG25SAV = value;
+	vdp_setRegister(25, value);
+}
+
+static uint16_t timeScrolls()
+{
+	uint16_t start = varJIFFY;
+
+	for (uint8_t i = 0; i < PANELSCROLL_TEST_LOOPS; i++) {
+		panelScrollUp();
+		panelScrollDown();
+	}
+	return varJIFFY - start;
+}
+
+
+// ========================================================
+// Chooses the faster engine. Must be called with the panel still empty.
+void panelScrollInit()
+{
+	uint16_t ticksCPU;
+
+	panelScrollVDP = false;
+	if (vdp_getVersion() != VDP_V9958) return;
+
+	originalRG25 = varRG25SAV;
+	setRG25(originalRG25 | PANELSCROLL_CMD_BIT);
+
+	ticksCPU = timeScrolls();
+	panelScrollVDP = true;
+	if (timeScrolls() >= ticksCPU) {
+		panelScrollRelease();
+	}
+}
+
+void panelScrollRelease()
+{
+	if (panelScrollVDP) {
+		setRG25(originalRG25);
+		panelScrollVDP = false;
+	}
+}
+
+// VRAM to VRAM copy (first 16K) with the engine chosen for the scroll
+void panelScrollCopy(uint16_t src, uint16_t dst, uint16_t size)
+{
+	if (panelScrollVDP) {
+		moveVDP(src, dst, size);
+	} else {
+		moveCPU(src, dst, size);
+	}
+}
+
+void panelScrollUp()
+{
+	panelScrollCopy(SECOND_ROW, FIRST_ROW, SCROLL_SIZE);
+	_fillVRAM(pageFlipTable+(PANEL_LASTY-1)*80, 80, ' ');
+	panelShadowScroll(true);
+}
+
+void panelScrollDown()
+{
+	panelScrollCopy(FIRST_ROW, SECOND_ROW, SCROLL_SIZE);
+	_fillVRAM(pageFlipTable+(PANEL_FIRSTY-1)*80, 80, ' ');
+	panelShadowScroll(false);
+}
@@ -0,0 +1,74 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "conio.h"
+#include "fh.h"
+#include "mod_panelShadow.h"
+#include "mod_pageFlip.h"
+
+
+// ========================================================
+static char shadow[PANEL_HEIGHT][PANELSHADOW_WIDTH];
+static bool valid[PANEL_HEIGHT];
+static char blank[PANELSHADOW_WIDTH];
+
+
+// ========================================================
+void panelShadowInvalidate()
+{
+	memset(valid, false, PANEL_HEIGHT);
+}
+
+void panelShadowPutLine(uint8_t y, char *line)
+{
+	uint8_t row = y - PANEL_FIRSTY;
+
+	if (valid[row] && !memcmp(shadow[row], line, PANELSHADOW_WIDTH)) return;
+
+	memcpy(shadow[row], line, PANELSHADOW_WIDTH);
+	valid[row] = true;
+	pageFlipPutLine(PANELSHADOW_POSX, y, PANELSHADOW_WIDTH, line);
+}
+
+// Writes a part of a row, len chars from pos
+void panelShadowPutText(uint8_t y, uint8_t pos, uint8_t len, char *text)
+{
+	memcpy(&shadow[y - PANEL_FIRSTY][pos], text, len);
+	pageFlipPutLine(PANELSHADOW_POSX + pos, y, len, text);
+}
+
+// Blanks the rows from y to the end of the panel
+void panelShadowClear(uint8_t y)
+{
+	if (blank[0] != ' ') {
+		memset(blank, ' ', PANELSHADOW_WIDTH);
+	}
+	while (y <= PANEL_LASTY) {
+		panelShadowPutLine(y++, blank);
+	}
+}
+
+// Follows panelScrollUp/panelScrollDown, which leave the new row blank
+void panelShadowScroll(bool up)
+{
+	const uint16_t size = (PANEL_HEIGHT - 1) * PANELSHADOW_WIDTH;
+	uint8_t row;
+
+	if (up) {
+		memmove(shadow[0], shadow[1], size);
+		memmove(&valid[0], &valid[1], PANEL_HEIGHT - 1);
+		row = PANEL_HEIGHT - 1;
+	} else {
+		memmove(shadow[1], shadow[0], size);
+		memmove(&valid[1], &valid[0], PANEL_HEIGHT - 1);
+		row = 0;
+	}
+	memset(shadow[row], ' ', PANELSHADOW_WIDTH);
+	valid[row] = true;
+}
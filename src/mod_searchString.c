@@ -10,7 +10,10 @@
 #include "conio.h"
 #include "fh.h"
 #include "utils.h"
+#include "mod_listView.h"
 #include "mod_searchString.h"
+#include "mod_pageFlip.h"
+#include "mod_overlay.h"
 
 
 // ========================================================
@@ -23,15 +26,12 @@ inline void printSearchString()
 	putstrxy(4, SEARCH_POSY+1, "Search:");
 }
 
-inline void clearSearchString()
-{
-	fillBlink(1,SEARCH_POSY, SEARCH_HEIGHT,80, false);
-}
-
 void changeSearchString()
 {
+	pageFlipHome();
 	ASM_EI; ASM_HALT;
 	setSelectedLine(false);
+	overlaySave(SEARCH_POSY, SEARCH_HEIGHT);
 	printSearchString();
 
 	*buff = '\0';
@@ -40,7 +40,7 @@ void changeSearchString()
 	bool needUpdate = *buff;
 
 	ASM_EI; ASM_HALT;
-	clearSearchString();
+	overlayRestore();
 
 	if (needUpdate) {
 		strcpy(request.search.value, buff);
@@ -51,7 +51,37 @@ void changeSearchString()
 	if (needUpdate) {
 		updateList();
 	} else {
-		printList();
 		setSelectedLine(true);
 	}
 }
+
+void changeFilterString()
+{
+	char text[SEARCH_MAX_SIZE + 1];
+	uint8_t len;
+	char key;
+
+	strcpy(text, listViewFilter);
+	len = strlen(text);
+
+	// The list is filtered again with every key
+	for (;;) {
+		printFilterString(true);
+		key = getch();
+		if (key == KEY_RETURN) break;
+		if (key == KEY_ESC) {
+			len = 0;
+		} else if (key == KEY_BS) {
+			if (!len) continue;
+			--len;
+		} else if (key >= ' ' && len < SEARCH_MAX_SIZE) {
+			text[len++] = key;
+		} else {
+			continue;
+		}
+		text[len] = '\0';
+		applyListFilter(text);
+		if (key == KEY_ESC) break;
+	}
+	printFilterString(false);
+}
@@ -0,0 +1,48 @@
+/*
+	Copyright (c) 2025 Natalia Pujol Cremades
+	info@abitwitches.com
+
+	See LICENSE file.
+*/
+#include <stdint.h>
+#include <stdbool.h>
+#include "msx_const.h"
+#include "mod_uiTasks.h"
+
+
+// ========================================================
+static UiTask_t tasks[UITASKS_COUNT];
+
+
+// ========================================================
+void uiTaskSet(uint8_t id, void (*run)(), uint8_t period)
+{
+	tasks[id].run = run;
+	tasks[id].period = period;
+	tasks[id].enabled = false;
+}
+
+// The first run will be delay frames from now
+void uiTaskStart(uint8_t id, uint8_t delay)
+{
+	tasks[id].next = varJIFFY + delay;
+	tasks[id].enabled = true;
+}
+
+void uiTaskStop(uint8_t id)
+{
+	tasks[id].enabled = false;
+}
+
+void uiTasksRun(uint8_t mask)
+{
+	UiTask_t *task = tasks;
+	uint16_t now = varJIFFY;
+
+	for (uint8_t id = 0; id < UITASKS_COUNT; id++, task++, mask >>= 1) {
+		if ((mask & 1) && task->enabled && (int16_t)(now - task->next) >= 0) {
+			task->next = now + task->period;
+			task->run();
+		}
+	}
+}